@@ -0,0 +1,944 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - lunebench.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Accuracy and throughput harness for liblune.
+//
+// Every code path is compared against a long double reference across
+// random dates from 1000 to 3000 CE. The reference evaluates the same
+// moontool theory with a fully converged Kepler solution, and the fuller
+// Meeus (Astronomical Algorithms, chapter 49) series for phase instants.
+// Apsides are checked against published instants and a fine search on the
+// chapter 47 distance series, and solar eclipses against published types
+// and magnitudes.
+// The harness reports the maximum and RMS error and the throughput of each
+// path, and exits with a failure when any error budget is exceeded.
+
+
+// C Library Includes
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++ Library Includes
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+// Local Includes
+#include <lune.hpp>
+#include <ephemeris.hpp>
+#include <lunesolver.hpp>
+#include <luneindex.hpp>
+#include <luneformat.hpp>
+#include <apsides.hpp>
+#include <eclipse.hpp>
+#include <clune.h>
+
+
+typedef long double real;
+
+
+// ------- Harness Constants
+
+static const double jd_first = 2086302.5;      // 1000 January 1
+static const double jd_last = 2816787.5;       // 3000 January 1
+static const int k_first = -11131;             // Lunation of 1000 January
+static const int k_last = 13604;               // Lunation of 3000 January
+static const unsigned seed = 2018;
+
+
+// ------- Reference Constants
+
+static const real epoch = 2444238.5L;
+static const real s_elonge = 278.833540L;
+static const real s_elongp = 282.596403L;
+static const real s_eccent = 0.016718L;
+static const real m_mlong = 64.975464L;
+static const real m_mlongp = 349.383063L;
+static const real m_mecc = 0.054900L;
+static const real m_smax = 384401.0L;
+static const real pi = 3.141592653589793238462643383279502884L;
+
+
+// ------- Useful mathematical functions
+
+static real fixedangle(real value) { return value - 360.0L * std::floor(value / 360.0L); }
+static real wrapangle(real value) { return value - 360.0L * std::floor((value + 180.0L) / 360.0L); }
+static real torad(real value) { return value * pi / 180.0L; }
+static real todeg(real value) { return value * 180.0L / pi; }
+static real dsin(real value) { return std::sin(torad(value)); }
+static real dcos(real value) { return std::cos(torad(value)); }
+
+
+// ------- Reference Implementation
+
+struct Reference {
+  real elongation;     // Degrees
+  real illuminated;
+  real dist;           // Kilometres
+};
+
+
+static real referenceKepler(const real& m, const real& ecc) {
+  real m2 = torad(m);
+  real e = m2;
+
+  for(int i = 0; i < 100; i++) {
+    real delta = e - ecc * std::sin(e) - m2;
+    e -= delta / (1 - ecc * std::cos(e));
+
+    if(std::abs(delta) <= 1e-18L)
+      break;
+  }
+
+  return e;
+}
+
+
+static void referencePhase(const real& jd, Reference& ref) {
+  real day = jd - epoch;
+
+  real m = fixedangle((360.0L / 365.2422L) * day + s_elonge - s_elongp);
+  real ecc = referenceKepler(m, s_eccent);
+  real nu = 2 * todeg(std::atan(std::sqrt((1 + s_eccent) / (1 - s_eccent)) * std::tan(ecc / 2)));
+  real lambda_sun = fixedangle(nu + s_elongp);
+
+  real ml = fixedangle(13.1763966L * day + m_mlong);
+  real mm = fixedangle(ml - 0.1114041L * day - m_mlongp);
+  real evection = 1.2739L * dsin(2 * (ml - lambda_sun) - mm);
+  real annual_eq = 0.1858L * dsin(m);
+  real a3 = 0.37L * dsin(m);
+  real mmp = mm + evection - annual_eq - a3;
+  real mec = 6.2886L * dsin(mmp);
+  real a4 = 0.214L * dsin(2 * mmp);
+  real lp = ml + evection + mec - annual_eq + a4;
+  real variation = 0.6593L * dsin(2 * (lp - lambda_sun));
+  real llp = lp + variation;
+
+  ref.elongation = fixedangle(llp - lambda_sun);
+  ref.illuminated = (1 - dcos(ref.elongation)) / 2;
+  ref.dist = (m_smax * (1 - m_mecc * m_mecc)) / (1 + m_mecc * dcos(mmp + mec));
+}
+
+
+static real referenceTruePhase(const int& k1900, const int& quarter) {
+  // Meeus chapter 49, lunations counted from 2000 January 6
+  real k = (k1900 - 1237) + quarter / 4.0L;
+  real t = k / 1236.85L;
+  real t2 = t * t, t3 = t2 * t, t4 = t3 * t;
+
+  real jde = 2451550.09766L + 29.530588861L * k + 0.00015437L * t2 - 0.000000150L * t3 + 0.00000000073L * t4;
+  real e = 1 - 0.002516L * t - 0.0000074L * t2;
+  real m = 2.5534L + 29.10535670L * k - 0.0000014L * t2 - 0.00000011L * t3;
+  real mp = 201.5643L + 385.81693528L * k + 0.0107582L * t2 + 0.00001238L * t3 - 0.000000058L * t4;
+  real f = 160.7108L + 390.67050284L * k - 0.0016118L * t2 - 0.00000227L * t3 + 0.000000011L * t4;
+  real om = 124.7746L - 1.56375588L * k + 0.0020672L * t2 + 0.00000215L * t3;
+
+  if(quarter == 0 || quarter == 2) {
+    bool nm = quarter == 0;
+    jde += (nm ? -0.40720L : -0.40614L) * dsin(mp)
+        + (nm ? 0.17241L : 0.17302L) * e * dsin(m)
+        + (nm ? 0.01608L : 0.01614L) * dsin(2 * mp)
+        + (nm ? 0.01039L : 0.01043L) * dsin(2 * f)
+        + (nm ? 0.00739L : 0.00734L) * e * dsin(mp - m)
+        + (nm ? -0.00514L : -0.00515L) * e * dsin(mp + m)
+        + (nm ? 0.00208L : 0.00209L) * e * e * dsin(2 * m)
+        - 0.00111L * dsin(mp - 2 * f)
+        - 0.00057L * dsin(mp + 2 * f)
+        + 0.00056L * e * dsin(2 * mp + m)
+        - 0.00042L * dsin(3 * mp)
+        + 0.00042L * e * dsin(m + 2 * f)
+        + 0.00038L * e * dsin(m - 2 * f)
+        - 0.00024L * e * dsin(2 * mp - m)
+        - 0.00017L * dsin(om)
+        - 0.00007L * dsin(mp + 2 * m)
+        + 0.00004L * dsin(2 * mp - 2 * f)
+        + 0.00004L * dsin(3 * m)
+        + 0.00003L * dsin(mp + m - 2 * f)
+        + 0.00003L * dsin(2 * mp + 2 * f)
+        - 0.00003L * dsin(mp + m + 2 * f)
+        + 0.00003L * dsin(mp - m + 2 * f)
+        - 0.00002L * dsin(mp - m - 2 * f)
+        - 0.00002L * dsin(3 * mp + m)
+        + 0.00002L * dsin(4 * mp);
+  } else {
+    jde += -0.62801L * dsin(mp)
+        + 0.17172L * e * dsin(m)
+        - 0.01183L * e * dsin(mp + m)
+        + 0.00862L * dsin(2 * mp)
+        + 0.00804L * dsin(2 * f)
+        + 0.00454L * e * dsin(mp - m)
+        + 0.00204L * e * e * dsin(2 * m)
+        - 0.00180L * dsin(mp - 2 * f)
+        - 0.00070L * dsin(mp + 2 * f)
+        - 0.00040L * dsin(3 * mp)
+        - 0.00034L * e * dsin(2 * mp - m)
+        + 0.00032L * e * dsin(m + 2 * f)
+        + 0.00032L * e * dsin(m - 2 * f)
+        - 0.00028L * e * e * dsin(mp + 2 * m)
+        + 0.00027L * e * dsin(2 * mp + m)
+        - 0.00017L * dsin(om)
+        - 0.00005L * dsin(mp - m - 2 * f)
+        + 0.00004L * dsin(2 * mp + 2 * f)
+        - 0.00004L * dsin(mp + m + 2 * f)
+        + 0.00004L * dsin(mp - 2 * m)
+        + 0.00003L * dsin(mp + m - 2 * f)
+        + 0.00003L * dsin(3 * m)
+        + 0.00002L * dsin(2 * mp - 2 * f)
+        + 0.00002L * dsin(mp - m + 2 * f)
+        - 0.00002L * dsin(3 * mp + m);
+
+    real w = 0.00306L - 0.00038L * e * dcos(m) + 0.00026L * dcos(mp)
+        - 0.00002L * dcos(mp - m) + 0.00002L * dcos(mp + m) + 0.00002L * dcos(2 * f);
+
+    jde += (quarter == 1) ? w : -w;
+  }
+
+  // Planetary arguments
+  static const real a_base[14] = { 299.77L, 251.88L, 251.83L, 349.42L, 84.66L, 141.74L, 207.14L, 154.84L, 34.52L, 207.19L, 291.34L, 161.72L, 239.56L, 331.55L };
+  static const real a_rate[14] = { 0.107408L, 0.016321L, 26.651886L, 36.412478L, 18.206239L, 53.303771L, 2.453732L, 7.306860L, 27.261239L, 0.121824L, 1.844379L, 24.198154L, 25.513099L, 3.592518L };
+  static const real a_coef[14] = { 0.000325L, 0.000165L, 0.000164L, 0.000126L, 0.000110L, 0.000062L, 0.000060L, 0.000056L, 0.000047L, 0.000042L, 0.000040L, 0.000037L, 0.000035L, 0.000023L };
+
+  for(int i = 0; i < 14; i++) {
+    real a = a_base[i] + a_rate[i] * k - (i == 0 ? 0.009173L * t2 : 0);
+    jde += a_coef[i] * dsin(a);
+  }
+
+  return jde;
+}
+
+
+static real referenceRoot(const real& target, real lo, real hi) {
+  // Bisection on the reference elongation
+  Reference ref;
+
+  while(hi - lo > 1e-10L) {
+    real mid = (lo + hi) / 2;
+    referencePhase(mid, ref);
+
+    if(wrapangle(ref.elongation - target) < 0)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  return (lo + hi) / 2;
+}
+
+
+static real referenceApsis(const int& type, real lo, real hi) {
+  // Golden section search on the perturbed distance, to well below the
+  // resolution at which a flat extremum stops changing a double distance
+  const real golden = 0.3819660112501051L;
+  const real sign = (type == APSIS_PERIGEE) ? 1 : -1;
+
+  real a = lo + golden * (hi - lo), b = hi - golden * (hi - lo);
+  real fa = sign * Ephemeris::calculatePerturbedDistance(a);
+  real fb = sign * Ephemeris::calculatePerturbedDistance(b);
+
+  while(hi - lo > 1e-8L) {
+    if(fa < fb) {
+      hi = b; b = a; fb = fa;
+      a = lo + golden * (hi - lo);
+      fa = sign * Ephemeris::calculatePerturbedDistance(a);
+    } else {
+      lo = a; a = b; fa = fb;
+      b = hi - golden * (hi - lo);
+      fb = sign * Ephemeris::calculatePerturbedDistance(b);
+    }
+  }
+
+  return (lo + hi) / 2;
+}
+
+
+static int referenceClass(const float& phase) {
+  // The per-call bisection nLune used to choose a phase string, with the
+  // trailing New Moon folded onto the first
+  static const float bp[] = { 0.05f, 0.2f, 0.3f, 0.45f, 0.55f, 0.7f, 0.8f, 0.95f, 1.05f };
+
+  for(int index = 0; index < 8; index++) {
+    float c = bp[index], d = bp[index], e = bp[index + 1];
+
+    while((e - d) >= 0.01) {
+      c = (d + e) / 2;
+      float fc = c*c*c - 2*c*c + 3, fd = d*d*d - 2*d*d + 3;
+
+      if(fc == 0.0)
+        break;
+      else if(fc * fd < 0)
+        e = c;
+      else
+        d = c;
+    }
+
+    if(phase < c)
+      return index;
+  }
+
+  return 0;
+}
+
+
+// ------- Error Statistics
+
+struct ErrorStat {
+  std::string path;
+  std::string quantity;
+  std::string unit;
+  double budget;
+  double max;
+  double sumsq;
+  long count;
+
+  ErrorStat(const std::string& p, const std::string& q, const std::string& u, const double& b) :
+    path(p), quantity(q), unit(u), budget(b), max(0), sumsq(0), count(0) {}
+
+  void add(const double& error) {
+    // A NaN error becomes the maximum and stays there, failing the budget
+    double a = std::abs(error);
+    if(std::isnan(a) || a > max)
+      max = a;
+    sumsq += a * a;
+    ++count;
+  }
+
+  double rms() const { return count ? std::sqrt(sumsq / count) : 0; }
+  bool passed() const { return max <= budget; }      // False for NaN
+};
+
+
+struct Throughput {
+  std::string path;
+  double ns;           // Nanoseconds per evaluation
+};
+
+
+static std::vector<ErrorStat> errors;
+static std::vector<Throughput> timings;
+static volatile double sink;
+
+
+template<typename F>
+static void measure(const std::string& path, const long& count, F func) {
+  auto start = std::chrono::steady_clock::now();
+  double acc = func();
+  auto stop = std::chrono::steady_clock::now();
+
+  sink = acc;
+  Throughput t = { path, std::chrono::duration<double, std::nano>(stop - start).count() / count };
+  timings.push_back(t);
+}
+
+
+// ------- Comparisons
+
+static void comparePhase(const std::vector<double>& dates) {
+  const long n = dates.size();
+
+  // Single precision carries the day count to only a few minutes at the
+  // ends of the range, which sets the float budgets.
+  ErrorStat f_elong("phase float", "elongation", "deg", 1.0);
+  ErrorStat f_illum("phase float", "illuminated", "frac", 0.01);
+  ErrorStat f_dist("phase float", "distance", "km", 350.0);
+  ErrorStat d_elong("phase double", "elongation", "deg", 1e-8);
+  ErrorStat d_illum("phase double", "illuminated", "frac", 1e-10);
+  ErrorStat d_dist("phase double", "distance", "km", 1e-5);
+  ErrorStat c_elong("phase C batch", "elongation", "deg", 1e-8);
+  ErrorStat c_illum("phase C batch", "illuminated", "frac", 1e-10);
+  ErrorStat c_dist("phase C batch", "distance", "km", 1e-5);
+
+  Lune moon;
+  Ephemeris eph;
+  Reference ref;
+
+  std::vector<double> c_phase(n), c_illuminated(n), c_distance(n);
+  lune_phase_batch(dates.data(), n, c_phase.data(), c_illuminated.data(), NULL, c_distance.data(), NULL);
+
+  for(long i = 0; i < n; i++) {
+    referencePhase(dates[i], ref);
+
+    moon.calculateAt(dates[i]);
+    f_elong.add(wrapangle(moon.getPhase() * 360.0L - ref.elongation));
+    f_illum.add(moon.getIlluminated() - ref.illuminated);
+    f_dist.add(moon.getDistance() - ref.dist);
+
+    eph.calculate(dates[i]);
+    d_elong.add(wrapangle(eph.getElongation() - ref.elongation));
+    d_illum.add(eph.getIlluminated() - ref.illuminated);
+    d_dist.add(eph.getDistance() - ref.dist);
+
+    c_elong.add(wrapangle(c_phase[i] * 360.0L - ref.elongation));
+    c_illum.add(c_illuminated[i] - ref.illuminated);
+    c_dist.add(c_distance[i] - ref.dist);
+  }
+
+  errors.push_back(f_elong);
+  errors.push_back(f_illum);
+  errors.push_back(f_dist);
+  errors.push_back(d_elong);
+  errors.push_back(d_illum);
+  errors.push_back(d_dist);
+  errors.push_back(c_elong);
+  errors.push_back(c_illum);
+  errors.push_back(c_dist);
+
+  measure("phase float", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++) {
+      moon.calculateAt(dates[i]);
+      acc += moon.getPhase();
+    }
+    return acc;
+  });
+
+  measure("phase double", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++) {
+      eph.calculate(dates[i]);
+      acc += eph.getPhase();
+    }
+    return acc;
+  });
+
+  std::vector<double> out(n);
+  measure("phase C batch", n, [&]() {
+    lune_phase_batch(dates.data(), n, out.data(), NULL, NULL, NULL, NULL);
+    return out[n - 1];
+  });
+}
+
+
+static void compareKepler(std::mt19937& rng, const long& n) {
+  std::uniform_real_distribution<double> anomaly(0.0, 360.0);
+  std::vector<double> m(n);
+  for(long i = 0; i < n; i++)
+    m[i] = anomaly(rng);
+
+  ErrorStat f_kepler("kepler float", "eccentric anomaly", "rad", 1e-6);
+  ErrorStat d_kepler("kepler double", "eccentric anomaly", "rad", 1e-12);
+  ErrorStat x_kepler("kepler fixed", "eccentric anomaly", "rad", 1e-12);
+  ErrorStat b_kepler("kepler batch", "eccentric anomaly", "rad", 1e-12);
+
+  std::vector<double> e(n);
+  Ephemeris::calculateKeplerBatch(m.data(), e.data(), n, s_eccent);
+
+  for(long i = 0; i < n; i++) {
+    real ref = referenceKepler(m[i], s_eccent);
+    f_kepler.add(Lune::calculateKepler(m[i], s_eccent) - ref);
+    d_kepler.add(Ephemeris::calculateKepler(m[i], s_eccent) - ref);
+    x_kepler.add(Ephemeris::calculateKeplerFixed(m[i], s_eccent) - ref);
+    b_kepler.add(e[i] - ref);
+  }
+
+  errors.push_back(f_kepler);
+  errors.push_back(d_kepler);
+  errors.push_back(x_kepler);
+  errors.push_back(b_kepler);
+
+  measure("kepler float", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += Lune::calculateKepler(m[i], s_eccent);
+    return acc;
+  });
+
+  measure("kepler double", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += Ephemeris::calculateKepler(m[i], s_eccent);
+    return acc;
+  });
+
+  measure("kepler fixed", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += Ephemeris::calculateKeplerFixed(m[i], s_eccent);
+    return acc;
+  });
+
+  measure("kepler batch", n, [&]() {
+    Ephemeris::calculateKeplerBatch(m.data(), e.data(), n, s_eccent);
+    return e[n - 1];
+  });
+}
+
+
+static void compareSweeps(const long& n) {
+  // Sequential daily and hourly sweeps through the ephemeris with each
+  // Kepler solver mode
+  static const char *mode_label[] = { "converge", "fixed", "warm" };
+  static const double steps[] = { 1.0, 1.0 / 24.0 };
+  static const char *step_label[] = { "daily", "hourly" };
+
+  for(int s = 0; s < 2; s++) {
+    ErrorStat sweep(std::string("sweep warm ") + step_label[s], "elongation", "deg", 1e-8);
+
+    Ephemeris eph;
+    Reference ref;
+    for(long i = 0; i < n; i++) {
+      double jd = jd_first + i * steps[s];
+      eph.calculate(jd);
+
+      // Compare a subset; the long double reference dominates the cost
+      if(i % 16 == 0) {
+        referencePhase(jd, ref);
+        sweep.add(wrapangle(eph.getElongation() - ref.elongation));
+      }
+    }
+
+    errors.push_back(sweep);
+
+    for(int mode = KEPLER_CONVERGE; mode <= KEPLER_WARM; mode++) {
+      eph.setKeplerMode(KeplerMode(mode));
+
+      measure(std::string("sweep ") + step_label[s] + " " + mode_label[mode], n, [&]() {
+        double acc = 0;
+        for(long i = 0; i < n; i++) {
+          eph.calculate(jd_first + i * steps[s]);
+          acc += eph.getPhase();
+        }
+        return acc;
+      });
+    }
+  }
+}
+
+
+static void compareTable(std::mt19937& rng, const long& n) {
+  // The phase class lookup table against the bisection it replaced, and
+  // prefix-sum window means against summing a Lune per day
+  std::uniform_real_distribution<float> fraction(0.0f, 1.0f);
+  std::vector<float> phases(n);
+  for(long i = 0; i < n; i++)
+    phases[i] = fraction(rng);
+
+  ErrorStat table("phase table", "class mismatch", "", 0);
+  for(long i = 0; i < n; i++)
+    table.add(Lune::calculatePhaseClass(phases[i]) != referenceClass(phases[i]));
+
+  errors.push_back(table);
+
+  measure("class table", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += Lune::calculatePhaseClass(phases[i]);
+    return acc;
+  });
+
+  measure("class bisect", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += referenceClass(phases[i]);
+    return acc;
+  });
+
+  // Windows of up to a thousand days over the harness range
+  const int first = int(jd_first + 0.5);
+  const int days = int(jd_last - jd_first);
+  const long queries = n / 1000 > 0 ? n / 1000 : 1;
+
+  std::uniform_int_distribution<int> start(first, first + days - 1000);
+  std::uniform_int_distribution<int> length(1, 1000);
+  std::vector<int> from(queries), to(queries);
+  for(long i = 0; i < queries; i++) {
+    from[i] = start(rng);
+    to[i] = from[i] + length(rng);
+  }
+
+  LuneIndex index;
+  measure("index build", days, [&]() {
+    index.build(first, days);
+    return 0.0;
+  });
+
+  ErrorStat window("index window", "mean illuminated", "", 1e-9);
+  Lune moon(jd_first);
+  for(long i = 0; i < queries; i++) {
+    double sum = 0;
+    for(int d = from[i]; d < to[i]; d++) {
+      moon.calculateAt(d);
+      sum += moon.getIlluminated();
+    }
+
+    window.add(index.getMeanIlluminated(from[i], to[i]) - sum / (to[i] - from[i]));
+  }
+
+  errors.push_back(window);
+
+  measure("window index", queries, [&]() {
+    double acc = 0;
+    for(long i = 0; i < queries; i++)
+      acc += index.getMeanIlluminated(from[i], to[i]);
+    return acc;
+  });
+
+  measure("window per day", queries, [&]() {
+    double acc = 0;
+    for(long i = 0; i < queries; i++) {
+      for(int d = from[i]; d < to[i]; d++) {
+        moon.calculateAt(d);
+        acc += moon.getIlluminated();
+      }
+    }
+    return acc;
+  });
+}
+
+
+static void compareFormat(std::mt19937& rng, const long& n) {
+  // The formatting layer against the std::to_string and snprintf paths it
+  // replaces; dates must match exactly, fixed point to half a last digit
+  const int first = int(jd_first + 0.5);
+  const int last = int(jd_last + 0.5);
+
+  std::uniform_int_distribution<int> day(first, last);
+  std::uniform_real_distribution<double> number(-1e6, 1e6);
+  std::uniform_int_distribution<int> places(0, 6);
+
+  std::vector<int> days(n), decimals(n);
+  std::vector<double> values(n);
+  for(long i = 0; i < n; i++) {
+    days[i] = day(rng);
+    values[i] = number(rng);
+    decimals[i] = places(rng);
+  }
+
+  char buf[LUNE_FIXED_SIZE], ref[64];
+  ErrorStat date("format date", "string mismatch", "", 0);
+  ErrorStat iso("format iso", "string mismatch", "", 0);
+  ErrorStat fixed("format fixed", "last decimal", "", 0.6);
+
+  for(long i = 0; i < n; i++) {
+    int dd, mm, yyyy;
+    Lune::calculateGregorian(days[i], dd, mm, yyyy);
+
+    LuneFormat::formatDate(days[i], buf);
+    std::string s = std::to_string(dd) + '/' + std::to_string(mm) + '/' + std::to_string(yyyy);
+    date.add(s != buf);
+
+    LuneFormat::formatISODate(days[i], buf);
+    std::snprintf(ref, sizeof(ref), "%04d-%02d-%02d", yyyy, mm, dd);
+    iso.add(std::strcmp(ref, buf) != 0);
+
+    LuneFormat::formatFixed(values[i], decimals[i], buf);
+    fixed.add((std::strtod(buf, 0) - values[i]) * std::pow(10.0, decimals[i]));
+  }
+
+  errors.push_back(date);
+  errors.push_back(iso);
+  errors.push_back(fixed);
+
+  measure("date to_string", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++) {
+      int dd, mm, yyyy;
+      Lune::calculateGregorian(days[i], dd, mm, yyyy);
+      acc += (std::to_string(dd) + '/' + std::to_string(mm) + '/' + std::to_string(yyyy)).size();
+    }
+    return acc;
+  });
+
+  measure("date table", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += LuneFormat::formatDate(days[i], buf);
+    return acc;
+  });
+
+  measure("iso snprintf", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++) {
+      int dd, mm, yyyy;
+      Lune::calculateGregorian(days[i], dd, mm, yyyy);
+      acc += std::snprintf(ref, sizeof(ref), "%04d-%02d-%02d", yyyy, mm, dd);
+    }
+    return acc;
+  });
+
+  measure("iso table", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += LuneFormat::formatISODate(days[i], buf);
+    return acc;
+  });
+
+  std::vector<char> out(n * LUNE_ISO_DATE_SIZE);
+  measure("iso batch", n, [&]() {
+    LuneFormat::formatISODates(&days[0], n, &out[0]);
+    return double(out[(n - 1) * LUNE_ISO_DATE_SIZE]);
+  });
+
+  // The batch inlines its own date arithmetic, so check every record, and
+  // the days either side of the clamped range
+  ErrorStat batch("format iso batch", "string mismatch", "", 0);
+  for(long i = 0; i < n; i++) {
+    LuneFormat::formatISODate(days[i], buf);
+    batch.add(std::strcmp(&out[i * LUNE_ISO_DATE_SIZE], buf) != 0);
+  }
+
+  const int edges[] = { INT_MIN, -1, 0, 1, 536000000, 536000001, INT_MAX };
+  char edge_out[sizeof(edges) / sizeof(edges[0]) * LUNE_ISO_DATE_SIZE];
+  LuneFormat::formatISODates(edges, sizeof(edges) / sizeof(edges[0]), edge_out);
+
+  for(std::size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+    LuneFormat::formatISODate(edges[i], buf);
+    batch.add(std::strcmp(&edge_out[i * LUNE_ISO_DATE_SIZE], buf) != 0);
+  }
+
+  errors.push_back(batch);
+
+  measure("fixed snprintf", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += std::snprintf(ref, sizeof(ref), "%.*f", decimals[i], values[i]);
+    return acc;
+  });
+
+  measure("fixed table", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += LuneFormat::formatFixed(values[i], decimals[i], buf);
+    return acc;
+  });
+}
+
+
+static void compareTruePhase(std::mt19937& rng, const long& n) {
+  std::uniform_int_distribution<int> lunation(k_first, k_last);
+  std::uniform_int_distribution<int> quarter(0, 3);
+  std::vector<int> k(n), q(n);
+  for(long i = 0; i < n; i++) {
+    k[i] = lunation(rng);
+    q[i] = quarter(rng);
+  }
+
+  ErrorStat truephase("true phase", "instant vs Meeus 49", "min", 20.0);
+  ErrorStat solver("solver", "instant vs reference root", "s", 1.0);
+
+  LuneSolver s;
+  for(long i = 0; i < n; i++) {
+    real ref = referenceTruePhase(k[i], q[i]);
+    truephase.add((Lune::calculateTruePhase(k[i], q[i] / 4.0) - ref) * 1440.0L);
+
+    double jd = s.solvePhase(k[i], q[i]);
+    real root = referenceRoot(q[i] * 90.0L, jd - 0.01L, jd + 0.01L);
+    solver.add((jd - root) * 86400.0L);
+  }
+
+  errors.push_back(truephase);
+  errors.push_back(solver);
+
+  measure("true phase", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += Lune::calculateTruePhase(k[i], q[i] / 4.0);
+    return acc;
+  });
+
+  measure("solver single", n, [&]() {
+    double acc = 0;
+    for(long i = 0; i < n; i++)
+      acc += s.solvePhase(k[i], q[i]);
+    return acc;
+  });
+
+  std::vector<LuneEvent> events;
+  events.reserve((jd_last - jd_first) / 29.530588 * 4 + 8);
+  auto start = std::chrono::steady_clock::now();
+  s.solveRange(jd_first, jd_last, events);
+  auto stop = std::chrono::steady_clock::now();
+
+  Throughput t = { "solver range", std::chrono::duration<double, std::nano>(stop - start).count() / events.size() };
+  timings.push_back(t);
+
+  // Streamed events start from carried offsets, so check them as well
+  ErrorStat range("solver range", "instant vs reference root", "s", 1.0);
+  for(std::size_t i = 0; i < events.size(); i += 16) {
+    const LuneEvent& e = events[i];
+    real root = referenceRoot(e.quarter * 90.0L, e.jd - 0.01L, e.jd + 0.01L);
+    range.add((e.jd - root) * 86400.0L);
+  }
+
+  errors.push_back(range);
+}
+
+
+static void compareEclipses() {
+  // Solar eclipses against the published type and greatest magnitude,
+  // including the non-central annular eclipse of 2014 April 29
+  struct Published { int dd, mm, yyyy, type; double magnitude; };
+  static const Published published[] = {
+    { 29, 4, 2014, ECLIPSE_ANNULAR, 0.9868 },
+    { 9, 3, 2016, ECLIPSE_TOTAL, 1.0450 },
+    { 21, 8, 2017, ECLIPSE_TOTAL, 1.0306 },
+    { 2, 7, 2019, ECLIPSE_TOTAL, 1.0459 },
+    { 21, 6, 2020, ECLIPSE_ANNULAR, 0.9940 },
+    { 25, 10, 2022, ECLIPSE_PARTIAL, 0.8619 },
+    { 20, 4, 2023, ECLIPSE_HYBRID, 1.0132 },
+    { 14, 10, 2023, ECLIPSE_ANNULAR, 0.9520 },
+    { 8, 4, 2024, ECLIPSE_TOTAL, 1.0566 },
+    { 2, 10, 2024, ECLIPSE_ANNULAR, 0.9326 }
+  };
+
+  ErrorStat type("eclipse solar", "type vs published", "", 0);
+  ErrorStat magnitude("eclipse solar", "magnitude vs published", "", 0.005);
+
+  EclipseFinder finder;
+  for(std::size_t i = 0; i < sizeof(published) / sizeof(published[0]); i++) {
+    const Published& p = published[i];
+
+    int jdn;
+    Lune::calculateJulianFromDate(p.dd, p.mm, p.yyyy, jdn);
+
+    std::vector<EclipseEvent> events;
+    finder.scan(jdn - 1.5, jdn + 1.5, events);
+
+    // A missing eclipse counts against both
+    bool found = events.size() == 1 && events[0].kind == ECLIPSE_SOLAR;
+    type.add(!found || events[0].type != p.type);
+    magnitude.add(found ? events[0].magnitude - p.magnitude : NAN);
+  }
+
+  errors.push_back(type);
+  errors.push_back(magnitude);
+}
+
+
+static void compareApsides() {
+  // The distance series against Meeus example 47.a, published 2024 perigees
+  // in UTC (the series runs in TT, about a minute later), and each streamed
+  // apsis against a golden section search on the same distance
+  ErrorStat series("apsis series", "distance vs Meeus 47.a", "km", 0.1);
+  series.add(Ephemeris::calculatePerturbedDistance(2448724.5) - 368409.7);
+  errors.push_back(series);
+
+  static const double published[] = {
+    2460322.5 + (10 * 60 + 35) / 1440.0,    // 2024 January 13 10:35
+    2460435.5 + (22 * 60 + 4) / 1440.0,     // 2024 May 5 22:04
+    2460656.5 + (13 * 60 + 21) / 1440.0     // 2024 December 12 13:21
+  };
+
+  ErrorStat perigee("apsis perigee", "instant vs published", "min", 5.0);
+  ApsisFinder finder;
+  ApsisEvent event;
+  finder.seek(2460310.5);
+
+  for(int i = 0; i < 3; i++) {
+    do {
+      finder.next(event);
+    } while(event.type != APSIS_PERIGEE || event.jd < published[i] - 2.0);
+
+    perigee.add((event.jd - published[i]) * 1440.0);
+  }
+
+  errors.push_back(perigee);
+
+  std::vector<ApsisEvent> events;
+  events.reserve((jd_last - jd_first) / 13.0 + 8);
+
+  ApsisFinder range;
+  auto start = std::chrono::steady_clock::now();
+  range.findRange(jd_first, jd_last, events);
+  auto stop = std::chrono::steady_clock::now();
+
+  Throughput t = { "apsis range", std::chrono::duration<double, std::nano>(stop - start).count() / events.size() };
+  timings.push_back(t);
+
+  ErrorStat instant("apsis range", "instant vs reference", "s", 10.0);
+  ErrorStat distance("apsis range", "distance vs reference", "km", 1e-4);
+  ErrorStat order("apsis range", "type out of order", "", 0);
+
+  for(std::size_t i = 0; i < events.size(); i++) {
+    const ApsisEvent& e = events[i];
+    if(i > 0)
+      order.add(e.type == events[i - 1].type);
+
+    if(i % 8)
+      continue;
+
+    real root = referenceApsis(e.type, e.jd - 0.5L, e.jd + 0.5L);
+    instant.add((e.jd - root) * 86400.0L);
+    distance.add(e.distance - Ephemeris::calculatePerturbedDistance(root));
+  }
+
+  errors.push_back(instant);
+  errors.push_back(distance);
+  errors.push_back(order);
+}
+
+
+// ------- Main Function
+
+int main(const int argc, const char *argv[]) {
+  // Optional scale factor for the sample counts
+  double scale = argc > 1 ? std::atof(argv[1]) : 1.0;
+  if(scale <= 0)
+    scale = 1.0;
+
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> date(jd_first, jd_last);
+
+  std::vector<double> dates(long(100000 * scale));
+  for(std::size_t i = 0; i < dates.size(); i++)
+    dates[i] = date(rng);
+
+  comparePhase(dates);
+  compareKepler(rng, long(500000 * scale));
+  compareTruePhase(rng, long(20000 * scale));
+  compareSweeps(long(100000 * scale));
+  compareTable(rng, long(500000 * scale));
+  compareFormat(rng, long(500000 * scale));
+  compareEclipses();
+  compareApsides();
+
+  // Report
+  bool passed = true;
+
+  std::printf("%-22s %-26s %12s %12s %12s %6s\n", "path", "quantity", "max error", "rms error", "budget", "");
+  for(std::size_t i = 0; i < errors.size(); i++) {
+    const ErrorStat& e = errors[i];
+    std::printf("%-22s %-26s %12.3e %12.3e %12.3e %-4s %s\n", e.path.c_str(), e.quantity.c_str(), e.max, e.rms(), e.budget, e.unit.c_str(), e.passed() ? "ok" : "FAIL");
+    passed = passed && e.passed();
+  }
+
+  std::printf("\n%-22s %12s\n", "path", "ns/eval");
+  for(std::size_t i = 0; i < timings.size(); i++)
+    std::printf("%-22s %12.1f\n", timings[i].path.c_str(), timings[i].ns);
+
+  if(!passed) {
+    std::fprintf(stderr, "[ERROR]: lunebench error budget exceeded.\n");
+    return 1;
+  }
+
+  return 0;
+}
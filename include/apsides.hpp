@@ -0,0 +1,124 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - apsides.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _APSIDES_HPP
+#define _APSIDES_HPP
+
+
+// ------- Includes
+
+// C++ Library Includes
+#include <vector>
+
+// Local Includes
+#include <ephemeris.hpp>
+#include <lunesolver.hpp>
+
+
+// ------- Apsis Classification
+
+enum ApsisType {
+  APSIS_PERIGEE = 0,
+  APSIS_APOGEE = 1
+};
+
+enum ApsisMoon {
+  MOON_ORDINARY = 0,
+  MOON_SUPER = 1,      // New or full moon near perigee
+  MOON_MICRO = 2       // New or full moon near apogee
+};
+
+
+// ------- Apsis Event
+
+struct ApsisEvent {
+  double jd;                 // Julian date of the apsis
+  double distance;           // Distance of the moon in km
+  int type;                  // ApsisType
+
+  // The new or full moon nearest the apsis
+  double syzygy_jd;
+  int syzygy_quarter;        // 0 New, 2 Full
+  double syzygy_distance;
+  double syzygy_angdia;      // Angular diameter in degrees
+  int moon;                  // ApsisMoon
+};
+
+
+// ------- ApsisFinder Class
+//
+// Samples the perturbed lunar distance of Meeus chapter 47 every three days
+// and brackets each perigee and apogee between three samples. The bracket is
+// refined by successive parabolic interpolation with golden section steps as
+// a safeguard, reusing the coarse samples as its starting points. The new
+// and full moons come from a LuneSolver stream which advances alongside the
+// apsides, and each apsis is checked against the nearest of them to flag
+// super and micro moons: within 10% of the perigee to apogee range of the
+// apsis itself.
+
+class ApsisFinder {
+private:
+  LuneSolver solver;
+
+  // Sampling window
+  double a_time[3];
+  double a_dist[3];
+  double a_from;             // Apsides before this date are skipped
+
+  // Most recent distance of each apsis type, for classification
+  double a_last[2];
+
+  // Syzygies either side of the current apsis
+  LuneEvent y_before;
+  LuneEvent y_after;
+
+  long evaluations;
+
+  // Calculation Functions
+  double calculateDistance(const double& jd);
+  double calculateExtremum(const int& type, double& distance);
+  void calculateSyzygy(ApsisEvent& event);
+  void advanceSyzygy();
+
+public:
+  ApsisFinder();
+  ~ApsisFinder() {}
+
+  // Streaming interface; next() yields apsides in order from the seek date
+  void seek(const double& jd);
+  void next(ApsisEvent& event);
+
+  // Batch interface; appends every apsis with from <= jd < to
+  void findRange(const double& from, const double& to, std::vector<ApsisEvent>& events);
+
+  const long& getEvaluations() { return evaluations; }
+};
+
+
+#endif // _APSIDES_HPP
@@ -0,0 +1,152 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - clune.h
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _CLUNE_H
+#define _CLUNE_H
+
+
+// ------- C Interface to liblune
+//
+// Every function works on whole arrays so callers from other runtimes pay a
+// single foreign call per batch. Output arrays must hold at least `count`
+// elements; any output pointer may be NULL to skip that quantity.
+
+
+#include <stddef.h>
+
+
+#if defined(_WIN32) && defined(LUNE_EXPORTS)
+  #define LUNE_API __declspec(dllexport)
+#elif defined(__GNUC__)
+  #define LUNE_API __attribute__((visibility("default")))
+#else
+  #define LUNE_API
+#endif
+
+
+// ------- Return Codes
+
+#define LUNE_OK      0
+#define LUNE_EINVAL -1
+#define LUNE_EFAIL  -2     // Out of memory or threads; outputs are unspecified
+
+
+// ------- Eclipse Classification
+
+#define LUNE_ECLIPSE_SOLAR     0
+#define LUNE_ECLIPSE_LUNAR     1
+
+#define LUNE_ECLIPSE_PENUMBRAL 0
+#define LUNE_ECLIPSE_PARTIAL   1
+#define LUNE_ECLIPSE_ANNULAR   2
+#define LUNE_ECLIPSE_HYBRID    3
+#define LUNE_ECLIPSE_TOTAL     4
+
+#define LUNE_APSIS_PERIGEE     0
+#define LUNE_APSIS_APOGEE      1
+
+#define LUNE_MOON_ORDINARY     0
+#define LUNE_MOON_SUPER        1
+#define LUNE_MOON_MICRO        2
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Phase (0-1), illuminated fraction, age in days, distance in km and angular
+// diameter in degrees of the moon for each Julian date in `jd`, computed in
+// double precision.
+LUNE_API int lune_phase_batch(const double *jd, size_t count, double *phase,
+  double *illuminated, double *age, double *dist, double *angdia);
+
+// Julian date of the phase `tphase` (0, 0.25, 0.5 or 0.75) for each lunation
+// `k` counted from the new moon of 1900 January.
+LUNE_API int lune_true_phase_batch(const double *k, size_t count, double tphase,
+  double *jd);
+
+// Exact instants of the phase events with from <= jd < to, in order, with
+// the Brown lunation number of each as in lune_lunation_batch and the quarter
+// (0 new, 1 first, 2 full, 3 last). At most `capacity` events are written and
+// `count` receives the number written. Both dates must be finite and within
+// +/- INT_MAX / 4 lunations of 1900.
+LUNE_API int lune_phase_events(double from, double to, double *jd,
+  int *lunation, int *quarter, size_t capacity, size_t *count);
+
+// Solar and lunar eclipses with from <= jd < to, in order, scanned over
+// `threads` workers a century at a time, so memory does not grow with the
+// range. At most `capacity` eclipses are written and `count` receives the
+// number written. Both dates must be finite and within +/- INT_MAX / 4
+// lunations of 1900.
+LUNE_API int lune_eclipses(double from, double to, int threads, double *jd,
+  int *kind, int *type, double *magnitude, size_t capacity, size_t *count);
+
+// Perigees and apogees with from <= jd < to, in order, with the distance in
+// km and whether the nearest new or full moon is a super or micro moon. At
+// most `capacity` apsides are written and `count` receives the number written.
+// Both dates must be finite and within +/- INT_MAX / 4 lunations of 1900.
+LUNE_API int lune_apsides(double from, double to, double *jd, int *type,
+  double *distance, int *moon, size_t capacity, size_t *count);
+
+// Moonrise, moonset and upper transit between jd and jd + 1 for each
+// observer at latitude `lat` and east longitude `lon` in degrees. Days
+// without an event report NAN.
+LUNE_API int lune_topocentric_day(double jd, const double *lat,
+  const double *lon, size_t count, double *rise, double *set, double *transit);
+
+// Topocentric altitude in degrees of the Moon at `jd` for each observer.
+LUNE_API int lune_topocentric_altitude(double jd, const double *lat,
+  const double *lon, size_t count, double *altitude);
+
+// Brown lunation number (lunation 1 began 1923 January 16) containing each
+// Julian date. Every date must be finite and within +/- INT_MAX / 4 lunations
+// of 1900.
+LUNE_API int lune_lunation_batch(const double *jd, size_t count, int *lunation);
+
+// Exact instants of the new, first quarter, full and last quarter moons of
+// lunations first to first + count - 1; `jd` receives 4 * count values.
+// Lunations must lie within +/- INT_MAX / 4.
+LUNE_API int lune_lunation_phases(int first, size_t count, double *jd);
+
+// Julian day numbers for each Gregorian date.
+LUNE_API int lune_julian_batch(const int *dd, const int *mm, const int *yyyy,
+  size_t count, int *jdn);
+
+// Gregorian dates for each Julian day number.
+LUNE_API int lune_gregorian_batch(const int *jdn, size_t count, int *dd,
+  int *mm, int *yyyy);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // _CLUNE_H
@@ -0,0 +1,98 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - eclipse.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _ECLIPSE_HPP
+#define _ECLIPSE_HPP
+
+
+// ------- Includes
+
+// C++ Library Includes
+#include <vector>
+
+
+// ------- Eclipse Classification
+
+enum EclipseKind {
+  ECLIPSE_SOLAR = 0,
+  ECLIPSE_LUNAR = 1
+};
+
+enum EclipseType {
+  ECLIPSE_PENUMBRAL = 0,   // Lunar only
+  ECLIPSE_PARTIAL = 1,
+  ECLIPSE_ANNULAR = 2,     // Solar only
+  ECLIPSE_HYBRID = 3,      // Solar only
+  ECLIPSE_TOTAL = 4
+};
+
+
+// ------- Eclipse Event
+
+struct EclipseEvent {
+  double jd;           // Julian Ephemeris Date of greatest eclipse
+  int lunation;        // Lunation k counted from the new moon of 1900 January
+  int kind;            // EclipseKind
+  int type;            // EclipseType
+  double gamma;        // Least distance of the shadow axis from the centre of the Earth or Moon
+  double magnitude;    // Greatest magnitude (umbral for lunar eclipses); for central
+                       // solar eclipses the Moon to Sun diameter ratio
+};
+
+
+// ------- EclipseFinder Class
+//
+// Walks the new and full moons of a range and discards every syzygy whose
+// argument of latitude places the Moon too far from a node to be eclipsed.
+// Only the survivors, roughly one in four, are evaluated with the fuller
+// series of Meeus, Astronomical Algorithms chapter 54.
+
+class EclipseFinder {
+private:
+  long candidates;     // Syzygies tested
+  long survivors;      // Syzygies passing the node distance test
+
+  // Calculation Functions
+  bool calculateNodeDistance(const int& k, const int& quarter);
+  bool calculateEclipse(const int& k, const int& quarter, EclipseEvent& event);
+  void scanLunations(const int& first, const int& last, const double& from, const double& to, std::vector<EclipseEvent>& events);
+
+public:
+  EclipseFinder() : candidates(0), survivors(0) {}
+  ~EclipseFinder() {}
+
+  // Appends every eclipse with from <= jd < to, split over `threads` workers
+  void scan(const double& from, const double& to, std::vector<EclipseEvent>& events, const int& threads = 1);
+
+  const long& getCandidates() { return candidates; }
+  const long& getSurvivors() { return survivors; }
+};
+
+
+#endif // _ECLIPSE_HPP
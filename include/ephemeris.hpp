@@ -0,0 +1,122 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - ephemeris.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _EPHEMERIS_HPP
+#define _EPHEMERIS_HPP
+
+
+// ------- Includes
+
+// C Library Includes
+#include <cstddef>
+
+
+// ------- Kepler Solver Modes
+
+enum KeplerMode {
+  KEPLER_CONVERGE = 0,   // Newton iteration until the residual converges
+  KEPLER_FIXED = 1,      // Series start and a fixed number of Newton steps
+  KEPLER_WARM = 2        // Start from the previous solution when it is close
+};
+
+
+// ------- Ephemeris Class
+//
+// Double precision evaluation of the moontool solar and lunar theory at an
+// arbitrary instant. Alongside the quantities computed by Lune it provides
+// the rate of change of the elongation, which the phase solvers use as the
+// derivative for Newton iteration.
+
+class Ephemeris {
+private:
+  double jday;
+
+  // Kepler Solver Variables
+  KeplerMode k_mode;
+  bool k_valid;          // A previous solution is available
+  double k_anomaly;      // Previous mean anomaly in radians
+  double k_solution;     // Previous eccentric anomaly in radians
+
+  // Solar Variables
+  double s_anomaly;      // Mean anomaly in degrees
+  double s_longitude;    // Geometric ecliptic longitude in degrees
+  double s_rate;         // Rate of change of the longitude in degrees per day
+  double s_dist;
+  double s_angdia;
+
+  // Lunar Variables
+  double m_longitude;    // Ecliptic longitude in degrees
+  double m_latitude;     // Ecliptic latitude in degrees
+  double m_elongation;   // Elongation from the Sun in degrees (0 - 360)
+  double m_rate;         // Rate of change of the elongation in degrees per day
+  double m_phase;
+  double m_illuminated;
+  double m_age;
+  double m_dist;
+  double m_angdia;
+  double m_parallax;     // Horizontal parallax in degrees
+
+public:
+  Ephemeris();
+  ~Ephemeris() {}
+
+  void calculate(const double& jd);
+  void setKeplerMode(const KeplerMode& mode) { k_mode = mode; k_valid = false; }
+
+  // Kepler solvers; anomalies in degrees in, radians out
+  static double calculateKepler(const double& m, const double& ecc);
+  static double calculateKeplerFixed(const double& m, const double& ecc);
+  static void calculateKeplerBatch(const double *m, double *e, const std::size_t& count, const double& ecc);
+  double calculateKeplerWarm(const double& m, const double& ecc);
+
+  // Geocentric distance of the Moon in km from the 60 principal periodic
+  // terms of Meeus, Astronomical Algorithms, chapter 47. The moontool
+  // distance above omits the perturbations which move the apsides by up to
+  // two days and their distances by thousands of km.
+  static double calculatePerturbedDistance(const double& jd);
+
+  const double& getJulianDate() { return jday; }
+  const double& getSunAnomaly() { return s_anomaly; }
+  const double& getSunLongitude() { return s_longitude; }
+  const double& getSunDistance() { return s_dist; }
+  const double& getSunAngularDiameter() { return s_angdia; }
+  const double& getLongitude() { return m_longitude; }
+  const double& getLatitude() { return m_latitude; }
+  const double& getElongation() { return m_elongation; }
+  const double& getElongationRate() { return m_rate; }
+  const double& getPhase() { return m_phase; }
+  const double& getIlluminated() { return m_illuminated; }
+  const double& getAge() { return m_age; }
+  const double& getDistance() { return m_dist; }
+  const double& getAngularDiameter() { return m_angdia; }
+  const double& getParallax() { return m_parallax; }
+};
+
+
+#endif // _EPHEMERIS_HPP
@@ -31,6 +31,32 @@ DEALINGS IN THE SOFTWARE.
 #define _LUNE_HPP
 
 
+// ------- Includes
+
+// C Library Includes
+#include <cstddef>
+#include <ctime>
+
+// C++ Library Includes
+#include <string>
+#include <vector>
+
+
+// ------- Phase Classes
+
+enum LunePhaseClass {
+  PHASE_NEW = 0,
+  PHASE_WAXING_CRESCENT,
+  PHASE_FIRST_QUARTER,
+  PHASE_WAXING_GIBBOUS,
+  PHASE_FULL,
+  PHASE_WANING_GIBBOUS,
+  PHASE_LAST_QUARTER,
+  PHASE_WANING_CRESCENT,
+  PHASE_CLASSES
+};
+
+
 // ------- Moon Class
 
 class Lune {
@@ -52,39 +78,76 @@ private:
   // Moon Strings
   std::string m_string;
   std::vector<std::string> m_phases;
+  std::vector<int> m_phase_days;
+  std::vector<double> m_phase_jd;       // Solved instants (UT) of the upcoming phases
 
   // Phase Calculation functions
-  void calculatePhase();
-  float calculateMeanPhase(const int& jdn, const float& k);
-  float calculateTruePhase(const float& k, const float& tphase);
-  float calculateKepler(const float& m, const float& ecc);
+  void calculatePhase(const double& jd);
 
   // Other Calculation functions
+  void calculateLune();
   void calculatePhaseString();
   void calculateNextPhase();
 
   // Calendar Calclation Functions
-  void calculateJulianFromDate(const int& dd, const int& mm, const int& yyyy, int& jdn);
   void calculateJulianFromTime(time_t* t, int& jdn);
-  void calculateGregorian(const int& jdn, int& dd, int& mm, int& yyyy);
   std::string calculateGregorianString(const int& jdn);
 
-  // Math Calculation Functions
-  float calculateFunc(const float& v);
-  void bisect(const float& a, const float& b, float& c);
-  void calculateRelativeDate(time_t *tin, time_t *tout, const int& days);
-
 public:
   Lune();
+  Lune(const time_t& t, const long& offset);   // Date at a UTC offset in seconds
+
+  // Phase quantities only, for an arbitrary Julian date. Nothing is read
+  // from the clock and the date strings and upcoming phases are left empty,
+  // so this is cheap and safe to call from any thread.
+  explicit Lune(const double& jd);
   ~Lune() {}
 
   void printLune();
 
+  // Recalculate the phase quantities for an arbitrary Julian date. The date
+  // strings and upcoming phases keep describing the constructed date.
+  void calculateAt(const double& jd);
+
+  // Lunation constants shared across the library
+  static const double synmonth;    // Synodic month (new Moon to new Moon), in days
+  static const double lunabase;    // Mean new moon of 1900 January, lunation k = 0
+  static const int lunatoffset;    // Lunation k of Brown's lunation 0
+
+  // Stateless calculations shared with the C interface
+  static double calculateTruePhase(const double& k, const double& tphase);
+  static double calculateLatitudeArgument(const double& k);   // Moon's F, in degrees
+  static float calculateKepler(const float& m, const float& ecc);
+  static void calculateJulianFromDate(const int& dd, const int& mm, const int& yyyy, int& jdn);
+  static void calculateJulianFromOffset(const time_t& t, const long& offset, int& jdn);
+  static void calculateGregorian(const int& jdn, int& dd, int& mm, int& yyyy);
+
+  // Phase string class of a phase fraction, from a lookup table rather than
+  // a search, and the string of each class
+  static int calculatePhaseClass(const float& phase);
+  static const std::string& getPhaseLabel(const int& phase_class);
+
+  // Lunation numbers in E. W. Brown's series, where lunation 1 began with
+  // the new moon of 1923 January 16. Each lookup is constant time; phase
+  // instants are written four per lunation (new, first, full, last).
+  static int calculateLunation(const double& jd);
+  static void calculateLunationPhases(const int& lunation, double *jd);
+  static void calculateLunationRange(const int& first, const std::size_t& count, double *jd);
+  static void calculateLunationBatch(const double *jd, const std::size_t& count, int *lunation);
+
   const float& getPhase() { return m_phase; }
+  const float& getIlluminated() { return m_illuminated; }
+  const float& getAge() { return m_age; }
+  const float& getDistance() { return m_dist; }
+  const float& getAngularDiameter() { return m_angdia; }
+  const float& getSunDistance() { return s_dist; }
+  const float& getSunAngularDiameter() { return s_angdia; }
   const int& getJulianDate() { return jdate; }
   const std::string& getDate() { return t_date; }
   const std::string& getPhaseString() { return m_string; }
   const std::vector<std::string>& getNextPhases() { return m_phases; }
+  const std::vector<int>& getNextPhaseDays() { return m_phase_days; }
+  const std::vector<double>& getNextPhaseInstants() { return m_phase_jd; }
 };
 
 
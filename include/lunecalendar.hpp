@@ -0,0 +1,71 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - lunecalendar.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _LUNECALENDAR_HPP
+#define _LUNECALENDAR_HPP
+
+
+// ------- Includes
+
+// C Library Includes
+#include <ctime>
+
+// C++ Library Includes
+#include <ostream>
+
+// Local Includes
+#include <lunesolver.hpp>
+#include <luneformat.hpp>
+
+
+// ------- LuneCalendar Class
+//
+// Writes the principal phases of a date range as an RFC 5545 calendar. Each
+// event is solved, formatted into a fixed buffer and written before the next
+// is solved, so memory use does not depend on the length of the range.
+
+class LuneCalendar {
+private:
+  LuneSolver solver;
+  char dtstamp[LUNE_ISO_DATETIME_SIZE];    // Generation time written as DTSTAMP
+
+  // Formatting Functions
+  std::size_t formatEvent(const LuneEvent& event, char* buf);
+
+public:
+  LuneCalendar();
+  ~LuneCalendar() {}
+
+  // Writes every event with from <= jd < to, within years 0000 to 9999,
+  // and returns the event count
+  long write(std::ostream& out, const double& from, const double& to);
+};
+
+
+#endif // _LUNECALENDAR_HPP
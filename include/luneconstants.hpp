@@ -0,0 +1,72 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - luneconstants.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _LUNECONSTANTS_HPP
+#define _LUNECONSTANTS_HPP
+
+
+// ------- Orbital Elements
+//
+// The moontool elements shared by the single and double precision theories
+// and the modules built on them. Internal to liblune: only its sources
+// include this header, so the names stay out of callers' scope.
+
+
+// ------- Astronomical Constants
+
+static const double epoch = 2444238.5;         // 1980 January 0.0
+static const double j2000 = 2451545.0;         // 2000 January 1.5
+
+
+// ------- Constants Defining the Sun's apparent orbit
+
+static const double s_elonge = 278.833540;     // Ecliptic longitude of the Sun at epoch 1980.0
+static const double s_elongp = 282.596403;     // Ecliptic longitude of the Sun at perigee
+static const double s_eccent = 0.016718;       // Eccentricity of earths orbit
+static const double s_smax = 1.49585e8;        // Semi-major axis of Earth's orbit, in kilometers
+static const double s_angsiz = 0.533128;       // Sun's angular size, in degrees, at semi-major axis distance
+static const double s_mrate = 360 / 365.2422;  // Daily motion of the Sun's mean anomaly
+
+
+// ------- Elements of the Moon's Orbit
+
+static const double m_mlong = 64.975464;       // Moon's mean longitude at the epoch
+static const double m_mlongp = 349.383063;     // Mean longitude of the perigee at the epoch
+static const double m_mlnode = 151.950429;     // Mean longitude of the node at the epoch
+static const double m_inc = 5.145396;          // Inclination of the Moon's orbit
+static const double m_mecc = 0.054900;         // Eccentricity of the Moon's orbit
+static const double m_angsiz = 0.5181;         // Moon's angular size at distance a from Earth
+static const double m_smax = 384401.0;         // Semi-major axis of the Moon's orbit, in kilometers
+static const double m_parallax_a = 0.9507;     // Parallax at a distance a from Earth
+static const double m_lrate = 13.1763966;      // Daily motion of the Moon's mean longitude
+static const double m_arate = 0.1114041;       // Daily motion of the perigee
+static const double m_nrate = 0.0529539;       // Daily regression of the node
+
+
+#endif // _LUNECONSTANTS_HPP
@@ -0,0 +1,85 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - luneformat.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _LUNEFORMAT_HPP
+#define _LUNEFORMAT_HPP
+
+
+// ------- Includes
+
+// C Library Includes
+#include <cstddef>
+
+
+// ------- Buffer Sizes
+//
+// Bytes, including the terminating NUL, that hold any output of each kind
+
+static const std::size_t LUNE_DATE_SIZE = 16;           // d/m/yyyy
+static const std::size_t LUNE_ISO_DATE_SIZE = 16;       // yyyy-mm-dd
+static const std::size_t LUNE_ISO_DATETIME_SIZE = 32;   // yyyy-mm-ddThh:mm:ssZ
+static const std::size_t LUNE_INTEGER_SIZE = 24;
+static const std::size_t LUNE_FIXED_SIZE = 32;
+
+
+// ------- LuneFormat Class
+//
+// Writes dates and numbers straight into caller buffers. Digits are emitted
+// two at a time from a table of pairs, and nothing is allocated, so bulk
+// output costs little more than the copy. Every function NUL terminates its
+// output and returns its length, like snprintf. Dates are clamped to Julian
+// day numbers 0 (-4713 November 24, proleptic Gregorian) to 536 000 000.
+
+class LuneFormat {
+public:
+  // Gregorian date of a Julian day number as d/m/yyyy, as nLune shows it
+  static std::size_t formatDate(const int& jdn, char* buf);
+
+  // ISO 8601 date of a Julian day number. Years outside 0 to 9999 take a
+  // sign and as many digits as they need.
+  static std::size_t formatISODate(const int& jdn, char* buf);
+
+  // ISO 8601 UTC date and time of a Julian date to the nearest second, in
+  // the basic (yyyymmddThhmmssZ) or extended format
+  static std::size_t formatISODateTime(const double& jd, char* buf, const bool& basic = false);
+
+  static std::size_t formatInteger(const long long& value, char* buf);
+
+  // Fixed point with 0 to 9 decimals, rounded to nearest. Values with 15
+  // or more digits, and non-finite values, are written by the C library in
+  // exponent notation.
+  static std::size_t formatFixed(const double& value, const int& decimals, char* buf);
+
+  // ISO 8601 dates of `count` Julian day numbers, each written to its own
+  // LUNE_ISO_DATE_SIZE record of `out`
+  static void formatISODates(const int *jdn, const std::size_t& count, char *out);
+};
+
+
+#endif // _LUNEFORMAT_HPP
@@ -0,0 +1,98 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - luneindex.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _LUNEINDEX_HPP
+#define _LUNEINDEX_HPP
+
+
+// ------- Includes
+
+// C++ Library Includes
+#include <vector>
+
+// Local Includes
+#include <lune.hpp>
+
+
+// ------- LuneIndex Class
+//
+// Daily records over a range of Julian day numbers, each taken at noon as
+// nLune does, with prefix sums of the illuminated fraction, distance and
+// angular diameter and a prefix count of each phase class. Any window mean
+// or class count is then two lookups, and the first day of a class after a
+// date is a binary search over its counts. Windows are half open, [from,
+// to), and are clipped to the indexed range.
+
+class LuneIndex {
+private:
+  int i_first;                            // First indexed Julian day number
+  int i_days;
+
+  // Daily records
+  std::vector<float> r_illuminated;
+  std::vector<float> r_distance;
+  std::vector<float> r_angdia;
+  std::vector<unsigned char> r_class;
+
+  // Prefix sums, one row more than the records
+  std::vector<double> p_illuminated;
+  std::vector<double> p_distance;
+  std::vector<double> p_angdia;
+  std::vector<int> p_class;               // PHASE_CLASSES counts per row
+
+  // Calculation Functions
+  void calculateRecords(const int& first, const int& last);
+  void calculatePrefix();
+  bool calculateWindow(const int& from, const int& to, int& a, int& b);
+  double calculateMean(const std::vector<double>& prefix, const int& from, const int& to);
+
+public:
+  LuneIndex();
+  ~LuneIndex() {}
+
+  // Index `days` days from Julian day number `first`, split over `threads`
+  void build(const int& first, const int& days, const int& threads = 1);
+
+  // Window queries; means are NAN over an empty window
+  double getMeanIlluminated(const int& from, const int& to);
+  double getMeanDistance(const int& from, const int& to);
+  double getMeanAngularDiameter(const int& from, const int& to);
+  int getClassCount(const int& from, const int& to, const int& phase_class);
+  void getClassCounts(const int& from, const int& to, int *counts);
+
+  // First day at or after `from` in the phase class, or -1 if none is indexed
+  int findClass(const int& from, const int& phase_class);
+
+  const int& getFirstDay() { return i_first; }
+  const int& getDays() { return i_days; }
+  int getClass(const int& jdn) { return r_class[jdn - i_first]; }
+};
+
+
+#endif // _LUNEINDEX_HPP
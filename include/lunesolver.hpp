@@ -0,0 +1,106 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - lunesolver.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _LUNESOLVER_HPP
+#define _LUNESOLVER_HPP
+
+
+// ------- Includes
+
+// C++ Library Includes
+#include <vector>
+
+// Local Includes
+#include <ephemeris.hpp>
+
+
+// ------- Phase Event
+
+struct LuneEvent {
+  double jd;       // Julian date of the event (UT)
+  int lunation;    // Lunation k counted from the new moon of 1900 January
+  int quarter;     // 0 New, 1 First Quarter, 2 Full, 3 Last Quarter
+};
+
+
+// ------- LuneSolver Class
+//
+// Finds the instant at which the elongation of the Moon reaches 0, 90, 180
+// or 270 degrees to within one second. Each event is bracketed around the
+// true phase estimate and refined by Newton iteration on the ephemeris
+// elongation, falling back to bisection whenever a step leaves the bracket.
+//
+// A Newton step is accepted without evaluating its result once the bound on
+// its quadratic error is below the tolerance. Sequential use through seek()
+// and next() carries the previous event over as the lower bracket of the
+// following one, and starts each event from its estimate corrected by the
+// offsets of the same quarter's last two roots, so most events in a stream
+// converge on the first evaluation.
+
+class LuneSolver {
+private:
+  Ephemeris eph;
+
+  // Stream state
+  int s_lunation;      // Lunation of the next event to solve
+  int s_quarter;       // Quarter of the next event to solve
+  bool s_linked;       // The previous event bounds the next one
+  double s_previous;   // Julian date of the previous event
+  double s_from;       // Events before this date are skipped
+  double s_offset[4][2]; // Root less estimate, last two lunations per quarter
+  int s_known[4];      // Offsets recorded per quarter since the last seek
+
+  long evaluations;    // Ephemeris evaluations since construction
+
+  // Solver functions
+  double calculateEstimate(const int& k, const int& quarter);
+  double solve(const double& target, double lo, double hi, double t);
+  void advance(LuneEvent& event);
+  void forget();
+
+public:
+  LuneSolver();
+  ~LuneSolver() {}
+
+  // Exact instant of a single phase event
+  double solvePhase(const int& k, const int& quarter);
+
+  // Streaming interface; next() yields events in order from the seek date
+  void seek(const double& jd);
+  void seekLunation(const int& k);
+  void next(LuneEvent& event);
+
+  // Batch interface; appends every event with from <= jd < to
+  void solveRange(const double& from, const double& to, std::vector<LuneEvent>& events);
+
+  const long& getEvaluations() { return evaluations; }
+};
+
+
+#endif // _LUNESOLVER_HPP
@@ -38,17 +38,30 @@ DEALINGS IN THE SOFTWARE.
 
 // C Library Includes
 #include <ctime>
+#include <cstdio>
 #include <cmath>
 #include <unistd.h>
 #include <ncurses.h>
 
 // C++ Library Includes
 #include <iostream>
+#include <fstream>
+#include <future>
 #include <string>
 #include <vector>
 
 // Local Includes
 #include <lune.hpp>
+#include <lunecalendar.hpp>
+#include <luneformat.hpp>
+
+
+// ------- Timezone shown in the multi-zone view
+
+struct nLuneZone {
+  std::string label;
+  long offset;        // Seconds east of UTC
+};
 
 
 // ------- nLune class
@@ -69,21 +82,32 @@ private:
   int min_y;
   int max_y;
 
+  // Multi-zone Variables
+  bool show_zones;
+  time_t zone_time;
+  std::vector<nLuneZone> zones;
+  std::vector<Lune> zone_moons;     // One per distinct Julian day
+  std::vector<int> zone_index;      // Index into zone_moons for each zone
+  std::vector<int> zone_days;       // Julian day of each of zone_moons
+
   // Private Functions
   void printBorder();
   void printData();
   void printMoon();
+  void printZones();
 
   void calculateResize();
+  void calculateZones();
 
   // Convenience Functions
   void refresh() { wrefresh(stdscr); }
 
 public:
-  nLune() {}
+  nLune() : initialized(false), show_zones(false), zone_time(0) {}
   ~nLune() {}
 
   // Public Functions
+  void setZones(const std::vector<nLuneZone>& z);
   void initialize();
   void execute();
   void finalize();
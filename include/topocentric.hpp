@@ -0,0 +1,95 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - topocentric.hpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _TOPOCENTRIC_HPP
+#define _TOPOCENTRIC_HPP
+
+
+// ------- Includes
+
+// C++ Library Includes
+#include <vector>
+
+// Local Includes
+#include <ephemeris.hpp>
+
+
+// ------- Topocentric Class
+//
+// Moonrise, moonset, upper transit and altitude for a set of observers.
+// The ephemeris, sidereal time and equatorial coordinates are evaluated
+// once per sample time and shared by every observer; each observer then
+// costs a handful of multiply-adds per sample. Observer data is held as
+// separate arrays so the per-sample loops vectorize across observers.
+//
+// Latitudes and longitudes are in degrees, longitudes positive east. Times
+// are Julian dates (UT); a day without an event reports NAN.
+
+class Topocentric {
+private:
+  Ephemeris eph;
+
+  // Observer Variables
+  std::vector<double> o_sinlat;
+  std::vector<double> o_coslat;
+  std::vector<double> o_sinlon;
+  std::vector<double> o_coslon;
+
+  // Per Observer Working Variables
+  std::vector<double> w_alt;     // sin(altitude) - sin(h0) at the previous sample
+  std::vector<double> w_ha;      // sin(hour angle) at the previous sample
+
+  // Results
+  std::vector<double> r_rise;
+  std::vector<double> r_set;
+  std::vector<double> r_transit;
+
+  // Calculation Functions
+  void calculateSample(const double& jd, double& sina, double& cosa, double& sindec, double& cosdec);
+
+public:
+  Topocentric() {}
+  ~Topocentric() {}
+
+  void setObservers(const std::vector<double>& lat, const std::vector<double>& lon);
+
+  // Events between jd and jd + 1, sampled every ten minutes
+  void calculateDay(const double& jd);
+
+  // Topocentric altitude in degrees of the Moon's centre for every observer
+  void calculateAltitude(const double& jd, std::vector<double>& altitude);
+
+  std::size_t getObservers() { return o_sinlat.size(); }
+  const std::vector<double>& getRise() { return r_rise; }
+  const std::vector<double>& getSet() { return r_set; }
+  const std::vector<double>& getTransit() { return r_transit; }
+};
+
+
+#endif // _TOPOCENTRIC_HPP
@@ -0,0 +1,224 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - apsides.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <cmath>
+
+// Local Includes
+#include <apsides.hpp>
+#include <luneconstants.hpp>
+
+
+// ------- Apsis Constants
+
+static const double step = 3.0;                // Coarse sampling interval, in days
+static const double tolerance = 60.0 / 86400.0;// Bracket width, in days
+static const double settle = 6.0 / 86400.0;    // Smallest step away from the centre point
+static const double golden = 0.3819660112501051;
+static const double fraction = 0.1;            // Super and micro moon share of the distance range
+static const int maxiter = 60;
+
+
+// ------- ApsisFinder Private Implementation
+
+double ApsisFinder::calculateDistance(const double& jd) {
+  ++evaluations;
+  return Ephemeris::calculatePerturbedDistance(jd);
+}
+
+
+double ApsisFinder::calculateExtremum(const int& type, double& distance) {
+  // Minimise the distance for a perigee and its negation for an apogee,
+  // starting from the three coarse samples a < b < c with f(b) lowest.
+  const double sign = (type == APSIS_PERIGEE) ? 1.0 : -1.0;
+
+  double a = a_time[0], b = a_time[1], c = a_time[2];
+  double fa = sign * a_dist[0], fb = sign * a_dist[1], fc = sign * a_dist[2];
+
+  for(int iter = 0; iter < maxiter && (c - a) > tolerance; iter++) {
+    // Vertex of the parabola through the three points
+    double p = (b - a) * (b - a) * (fb - fc) - (b - c) * (b - c) * (fb - fa);
+    double q = (b - a) * (fb - fc) - (b - c) * (fb - fa);
+    double u = (q != 0) ? b - 0.5 * p / q : b;
+
+    // Fall back to a golden section step into the larger segment when the
+    // vertex leaves the bracket
+    bool parabolic = (u > a && u < c);
+    if(!parabolic) {
+      if((b - a) > (c - b))
+        u = b - golden * (b - a);
+      else
+        u = b + golden * (c - b);
+    }
+
+    // A vertex on the centre point says nothing about the bracket, so step
+    // a settle away from it to let the far side close in
+    if(parabolic && std::abs(u - b) < settle)
+      u = (u < b) ? std::fmax(b - settle, 0.5 * (a + b)) : std::fmin(b + settle, 0.5 * (b + c));
+
+    double fu = sign * calculateDistance(u);
+
+    // Keep the lowest point in the middle of the bracket
+    if(fu < fb) {
+      if(u < b) {
+        c = b; fc = fb;
+      } else {
+        a = b; fa = fb;
+      }
+      b = u; fb = fu;
+    } else {
+      if(u < b) {
+        a = u; fa = fu;
+      } else {
+        c = u; fc = fu;
+      }
+    }
+  }
+
+  distance = sign * fb;
+  return b;
+}
+
+
+void ApsisFinder::advanceSyzygy() {
+  // Step the solver stream to the next new or full moon
+  y_before = y_after;
+
+  do {
+    solver.next(y_after);
+  } while(y_after.quarter != 0 && y_after.quarter != 2);
+}
+
+
+void ApsisFinder::calculateSyzygy(ApsisEvent& event) {
+  while(y_after.jd < event.jd)
+    advanceSyzygy();
+
+  const LuneEvent& nearest = (event.jd - y_before.jd) < (y_after.jd - event.jd) ? y_before : y_after;
+
+  event.syzygy_jd = nearest.jd;
+  event.syzygy_quarter = nearest.quarter;
+  event.syzygy_distance = calculateDistance(nearest.jd);
+  event.syzygy_angdia = m_angsiz * m_smax / event.syzygy_distance;
+
+  // Distance range of this orbit from the apsis and the latest opposite one
+  double perigee = (event.type == APSIS_PERIGEE) ? event.distance : a_last[APSIS_PERIGEE];
+  double apogee = (event.type == APSIS_APOGEE) ? event.distance : a_last[APSIS_APOGEE];
+  double margin = fraction * (apogee - perigee);
+
+  event.moon = MOON_ORDINARY;
+
+  if(event.type == APSIS_PERIGEE && event.syzygy_distance <= perigee + margin)
+    event.moon = MOON_SUPER;
+  else if(event.type == APSIS_APOGEE && event.syzygy_distance >= apogee - margin)
+    event.moon = MOON_MICRO;
+}
+
+
+// ------- ApsisFinder Public Implementation
+
+ApsisFinder::ApsisFinder() : a_from(0), evaluations(0) {
+  // Nominal apsides until the first of each has been found
+  a_last[APSIS_PERIGEE] = m_smax * (1 - m_mecc);
+  a_last[APSIS_APOGEE] = m_smax * (1 + m_mecc);
+
+  for(int i = 0; i < 3; i++) {
+    a_time[i] = 0;
+    a_dist[i] = 0;
+  }
+
+  y_before.jd = y_after.jd = 0;
+  y_before.lunation = y_after.lunation = 0;
+  y_before.quarter = y_after.quarter = 0;
+}
+
+
+void ApsisFinder::seek(const double& jd) {
+  a_from = jd;
+
+  // Prime the window so the first triple ends at jd + step
+  for(int i = 0; i < 2; i++) {
+    a_time[i + 1] = jd - step + i * step;
+    a_dist[i + 1] = calculateDistance(a_time[i + 1]);
+  }
+
+  // Start the syzygy stream one synodic half month earlier
+  solver.seek(jd - 16.0);
+  y_after.jd = jd - 16.0;
+  advanceSyzygy();
+  advanceSyzygy();
+}
+
+
+void ApsisFinder::next(ApsisEvent& event) {
+  while(1) {
+    // Slide the window forward by one sample
+    a_time[0] = a_time[1]; a_dist[0] = a_dist[1];
+    a_time[1] = a_time[2]; a_dist[1] = a_dist[2];
+    a_time[2] = a_time[1] + step;
+    a_dist[2] = calculateDistance(a_time[2]);
+
+    int type;
+    if(a_dist[1] < a_dist[0] && a_dist[1] <= a_dist[2])
+      type = APSIS_PERIGEE;
+    else if(a_dist[1] > a_dist[0] && a_dist[1] >= a_dist[2])
+      type = APSIS_APOGEE;
+    else
+      continue;
+
+    event.type = type;
+    event.jd = calculateExtremum(type, event.distance);
+
+    if(event.jd < a_from) {
+      a_last[type] = event.distance;
+      continue;
+    }
+
+    calculateSyzygy(event);
+    a_last[type] = event.distance;
+    return;
+  }
+}
+
+
+void ApsisFinder::findRange(const double& from, const double& to, std::vector<ApsisEvent>& events) {
+  if(to <= from)
+    return;
+
+  ApsisEvent event;
+  seek(from);
+
+  while(1) {
+    next(event);
+    if(event.jd >= to)
+      break;
+
+    events.push_back(event);
+  }
+}
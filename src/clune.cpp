@@ -0,0 +1,301 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - clune.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <climits>
+#include <cmath>
+
+// Local Includes
+#include <lune.hpp>
+#include <ephemeris.hpp>
+#include <lunesolver.hpp>
+#include <eclipse.hpp>
+#include <apsides.hpp>
+#include <topocentric.hpp>
+#include <clune.h>
+
+
+// ------- Interface Constants
+
+static const double eclipse_window = 36525.0;  // Days scanned per block, one century
+static const int lunation_limit = INT_MAX / 4;   // Lunation numbers are counted per event in an int
+
+
+// ------- Helper functions
+
+static bool validdate(const double& jd) {
+  // Finite and within the lunations an int can count; NaN fails the test
+  return std::fabs(jd - Lune::lunabase) < lunation_limit * Lune::synmonth;
+}
+
+
+static bool validphase(const double& tphase) {
+  // Only the four principal phases have true phase corrections
+  return (tphase == 0.0) || (tphase == 0.25) || (tphase == 0.5) || (tphase == 0.75);
+}
+
+
+// ------- C Interface Implementation
+
+extern "C" {
+
+
+int lune_phase_batch(const double *jd, size_t count, double *phase,
+  double *illuminated, double *age, double *dist, double *angdia) {
+  if(count > 0 && !jd)
+    return LUNE_EINVAL;
+
+  // The double precision theory, so callers get the precision they are
+  // handed; one Ephemeris lets the Kepler solver warm start along sweeps
+  Ephemeris eph;
+
+  for(size_t i = 0; i < count; i++) {
+    eph.calculate(jd[i]);
+
+    if(phase) phase[i] = eph.getPhase();
+    if(illuminated) illuminated[i] = eph.getIlluminated();
+    if(age) age[i] = eph.getAge();
+    if(dist) dist[i] = eph.getDistance();
+    if(angdia) angdia[i] = eph.getAngularDiameter();
+  }
+
+  return LUNE_OK;
+}
+
+
+int lune_true_phase_batch(const double *k, size_t count, double tphase,
+  double *jd) {
+  if((count > 0 && (!k || !jd)) || !validphase(tphase))
+    return LUNE_EINVAL;
+
+  for(size_t i = 0; i < count; i++)
+    jd[i] = Lune::calculateTruePhase(k[i], tphase);
+
+  return LUNE_OK;
+}
+
+
+int lune_phase_events(double from, double to, double *jd,
+  int *lunation, int *quarter, size_t capacity, size_t *count) {
+  if(!count || (capacity > 0 && !jd) || !validdate(from) || !validdate(to))
+    return LUNE_EINVAL;
+
+  *count = 0;
+  if(to <= from)
+    return LUNE_OK;
+
+  LuneSolver solver;
+  LuneEvent event;
+  solver.seek(from);
+
+  while(*count < capacity) {
+    solver.next(event);
+    if(event.jd >= to)
+      break;
+
+    jd[*count] = event.jd;
+    if(lunation) lunation[*count] = event.lunation - Lune::lunatoffset;
+    if(quarter) quarter[*count] = event.quarter;
+    ++(*count);
+  }
+
+  return LUNE_OK;
+}
+
+
+int lune_eclipses(double from, double to, int threads, double *jd,
+  int *kind, int *type, double *magnitude, size_t capacity, size_t *count) {
+  if(!count || (capacity > 0 && !jd) || !validdate(from) || !validdate(to))
+    return LUNE_EINVAL;
+
+  *count = 0;
+
+  try {
+    // Scan a century at a time so memory stays bounded over long ranges
+    // and the scan stops once capacity is reached
+    EclipseFinder finder;
+    std::vector<EclipseEvent> events;
+
+    for(double a = from; a < to && *count < capacity; a += eclipse_window) {
+      double b = std::fmin(a + eclipse_window, to);
+
+      events.clear();
+      finder.scan(a, b, events, threads);
+
+      for(size_t i = 0; i < events.size() && *count < capacity; i++) {
+        size_t n = *count;
+
+        jd[n] = events[i].jd;
+        if(kind) kind[n] = events[i].kind;
+        if(type) type[n] = events[i].type;
+        if(magnitude) magnitude[n] = events[i].magnitude;
+        ++(*count);
+      }
+    }
+  } catch(...) {
+    return LUNE_EFAIL;
+  }
+
+  return LUNE_OK;
+}
+
+
+int lune_apsides(double from, double to, double *jd, int *type,
+  double *distance, int *moon, size_t capacity, size_t *count) {
+  if(!count || (capacity > 0 && !jd) || !validdate(from) || !validdate(to))
+    return LUNE_EINVAL;
+
+  *count = 0;
+
+  if(to <= from)
+    return LUNE_OK;
+
+  // Stream rather than collect, so long ranges stop at capacity
+  ApsisFinder finder;
+  ApsisEvent event;
+  finder.seek(from);
+
+  for(size_t i = 0; i < capacity; i++) {
+    finder.next(event);
+    if(event.jd >= to)
+      break;
+
+    jd[i] = event.jd;
+    if(type) type[i] = event.type;
+    if(distance) distance[i] = event.distance;
+    if(moon) moon[i] = event.moon;
+    ++(*count);
+  }
+
+  return LUNE_OK;
+}
+
+
+int lune_topocentric_day(double jd, const double *lat,
+  const double *lon, size_t count, double *rise, double *set, double *transit) {
+  if(count > 0 && (!lat || !lon))
+    return LUNE_EINVAL;
+
+  try {
+    Topocentric topo;
+    topo.setObservers(std::vector<double>(lat, lat + count), std::vector<double>(lon, lon + count));
+    topo.calculateDay(jd);
+
+    for(size_t i = 0; i < count; i++) {
+      if(rise) rise[i] = topo.getRise()[i];
+      if(set) set[i] = topo.getSet()[i];
+      if(transit) transit[i] = topo.getTransit()[i];
+    }
+  } catch(...) {
+    return LUNE_EFAIL;
+  }
+
+  return LUNE_OK;
+}
+
+
+int lune_topocentric_altitude(double jd, const double *lat,
+  const double *lon, size_t count, double *altitude) {
+  if(count > 0 && (!lat || !lon || !altitude))
+    return LUNE_EINVAL;
+
+  try {
+    Topocentric topo;
+    std::vector<double> result;
+    topo.setObservers(std::vector<double>(lat, lat + count), std::vector<double>(lon, lon + count));
+    topo.calculateAltitude(jd, result);
+
+    for(size_t i = 0; i < count; i++)
+      altitude[i] = result[i];
+  } catch(...) {
+    return LUNE_EFAIL;
+  }
+
+  return LUNE_OK;
+}
+
+
+int lune_lunation_batch(const double *jd, size_t count, int *lunation) {
+  if(count > 0 && (!jd || !lunation))
+    return LUNE_EINVAL;
+
+  // The lunation must fit an int
+  for(size_t i = 0; i < count; i++) {
+    if(!validdate(jd[i]))
+      return LUNE_EINVAL;
+  }
+
+  Lune::calculateLunationBatch(jd, count, lunation);
+  return LUNE_OK;
+}
+
+
+int lune_lunation_phases(int first, size_t count, double *jd) {
+  // Lunation numbers, counted per event by the solver, must stay in an int
+  const long long limit = lunation_limit;
+
+  if((count > 0 && !jd) || first < -limit || first > limit || count > (unsigned long long)(limit - first))
+    return LUNE_EINVAL;
+
+  Lune::calculateLunationRange(first, count, jd);
+  return LUNE_OK;
+}
+
+
+int lune_julian_batch(const int *dd, const int *mm, const int *yyyy,
+  size_t count, int *jdn) {
+  if(count > 0 && (!dd || !mm || !yyyy || !jdn))
+    return LUNE_EINVAL;
+
+  for(size_t i = 0; i < count; i++)
+    Lune::calculateJulianFromDate(dd[i], mm[i], yyyy[i], jdn[i]);
+
+  return LUNE_OK;
+}
+
+
+int lune_gregorian_batch(const int *jdn, size_t count, int *dd,
+  int *mm, int *yyyy) {
+  if(count > 0 && !jdn)
+    return LUNE_EINVAL;
+
+  int d, m, y;
+  for(size_t i = 0; i < count; i++) {
+    Lune::calculateGregorian(jdn[i], d, m, y);
+
+    if(dd) dd[i] = d;
+    if(mm) mm[i] = m;
+    if(yyyy) yyyy[i] = y;
+  }
+
+  return LUNE_OK;
+}
+
+
+} // extern "C"
@@ -0,0 +1,257 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - eclipse.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <cmath>
+
+// C++ Library Includes
+#include <algorithm>
+#include <thread>
+
+// Local Includes
+#include <lune.hpp>
+#include <eclipse.hpp>
+
+
+// ------- Eclipse Constants
+
+static const int lunaoffset = 1237;            // Lunations from 1900 January to 2000 January 6
+static const double nodelimit = 0.36;          // No eclipse is possible while |sin F| exceeds this
+
+
+// ------- Useful mathematical functions
+
+static double torad(double value) { return value * M_PI / 180.0; }
+static double dsin(double value) { return std::sin(torad(value)); }
+static double dcos(double value) { return std::cos(torad(value)); }
+
+
+// ------- EclipseFinder Private Implementation
+
+bool EclipseFinder::calculateNodeDistance(const int& k, const int& quarter) {
+  // The same argument of latitude as Lune::calculateTruePhase
+  double f = Lune::calculateLatitudeArgument(k + quarter / 4.0);
+
+  return std::abs(dsin(f)) <= nodelimit;
+}
+
+
+bool EclipseFinder::calculateEclipse(const int& k, const int& quarter, EclipseEvent& event) {
+  // Lunations counted from 2000 January 6 as in Meeus
+  double k2 = (k - lunaoffset) + quarter / 4.0;
+
+  double t = k2 / 1236.85;
+  double t2 = t * t;
+  double t3 = t2 * t;
+  double t4 = t3 * t;
+
+  double jde = 2451550.09766 + 29.530588861 * k2 + 0.00015437 * t2 - 0.000000150 * t3 + 0.00000000073 * t4;
+
+  // Eccentricity of the Earth's orbit, mean anomalies and argument of latitude
+  double e = 1 - 0.002516 * t - 0.0000074 * t2;
+  double m = 2.5534 + 29.10535670 * k2 - 0.0000014 * t2 - 0.00000011 * t3;
+  double mp = 201.5643 + 385.81693528 * k2 + 0.0107582 * t2 + 0.00001238 * t3 - 0.000000058 * t4;
+  double f = 160.7108 + 390.67050284 * k2 - 0.0016118 * t2 - 0.00000227 * t3 + 0.000000011 * t4;
+  double omega = 124.7746 - 1.56375588 * k2 + 0.0020672 * t2 + 0.00000215 * t3;
+
+  double f1 = f - 0.02665 * dsin(omega);
+  double a1 = 299.77 + 0.107408 * k2 - 0.009173 * t2;
+
+  // Time of greatest eclipse
+  if(quarter == 0)
+    jde += -0.4075 * dsin(mp) + 0.1721 * e * dsin(m);
+  else
+    jde += -0.4065 * dsin(mp) + 0.1727 * e * dsin(m);
+
+  jde += 0.0161 * dsin(2 * mp)
+      - 0.0097 * dsin(2 * f1)
+      + 0.0073 * e * dsin(mp - m)
+      - 0.0050 * e * dsin(mp + m)
+      - 0.0023 * dsin(mp - 2 * f1)
+      + 0.0021 * e * dsin(2 * m)
+      + 0.0012 * dsin(mp + 2 * f1)
+      + 0.0006 * e * dsin(2 * mp + m)
+      - 0.0004 * dsin(3 * mp)
+      - 0.0003 * e * dsin(m + 2 * f1)
+      + 0.0003 * dsin(a1)
+      - 0.0002 * e * dsin(m - 2 * f1)
+      - 0.0002 * e * dsin(2 * mp - m)
+      - 0.0002 * dsin(omega);
+
+  // Position of the shadow axis
+  double p = 0.2070 * e * dsin(m)
+      + 0.0024 * e * dsin(2 * m)
+      - 0.0392 * dsin(mp)
+      + 0.0116 * dsin(2 * mp)
+      - 0.0073 * e * dsin(mp + m)
+      + 0.0067 * e * dsin(mp - m)
+      + 0.0118 * dsin(2 * f1);
+
+  double q = 5.2207
+      - 0.0048 * e * dcos(m)
+      + 0.0020 * e * dcos(2 * m)
+      - 0.3299 * dcos(mp)
+      - 0.0060 * e * dcos(mp + m)
+      + 0.0041 * e * dcos(mp - m);
+
+  double w = std::abs(dcos(f1));
+  double gamma = (p * dcos(f1) + q * dsin(f1)) * (1 - 0.0048 * w);
+
+  // Radius of the umbral cone in the fundamental plane
+  double u = 0.0059
+      + 0.0046 * e * dcos(m)
+      - 0.0182 * dcos(mp)
+      + 0.0004 * dcos(2 * mp)
+      - 0.0005 * dcos(m + mp);
+
+  double agamma = std::abs(gamma);
+
+  event.jd = jde;
+  event.lunation = k;
+  event.gamma = gamma;
+
+  if(quarter == 0) {
+    // Solar eclipse
+    event.kind = ECLIPSE_SOLAR;
+
+    if(agamma > 1.5433 + u)
+      return false;
+
+    if(agamma < 0.9972) {
+      // Central eclipse
+      double omegalim = 0.00464 * std::sqrt(1 - gamma * gamma);
+
+      if(u < 0)
+        event.type = ECLIPSE_TOTAL;
+      else if(u > 0.0047 || u >= omegalim)
+        event.type = ECLIPSE_ANNULAR;
+      else
+        event.type = ECLIPSE_HYBRID;
+
+      // Ratio of the apparent diameters where the axis meets the surface,
+      // which is nearer the Moon than the fundamental plane; both cones
+      // widen there by omegalim (Besselian magnitude (L1 - L2) / (L1 + L2))
+      event.magnitude = (0.5461 + 2 * omegalim) / (0.5461 + 2 * u);
+    } else {
+      // The edge of the umbral cone can still touch the Earth, giving a
+      // non-central total or annular eclipse
+      if(agamma < 0.9972 + std::abs(u))
+        event.type = (u < 0) ? ECLIPSE_TOTAL : ECLIPSE_ANNULAR;
+      else
+        event.type = ECLIPSE_PARTIAL;
+
+      event.magnitude = (1.5433 + u - agamma) / (0.5461 + 2 * u);
+    }
+  } else {
+    // Lunar eclipse
+    event.kind = ECLIPSE_LUNAR;
+
+    double penumbral = (1.5573 + u - agamma) / 0.5450;
+    double umbral = (1.0128 - u - agamma) / 0.5450;
+
+    if(penumbral < 0)
+      return false;
+
+    if(umbral >= 1)
+      event.type = ECLIPSE_TOTAL;
+    else if(umbral > 0)
+      event.type = ECLIPSE_PARTIAL;
+    else
+      event.type = ECLIPSE_PENUMBRAL;
+
+    event.magnitude = (umbral > 0) ? umbral : penumbral;
+  }
+
+  return true;
+}
+
+
+void EclipseFinder::scanLunations(const int& first, const int& last, const double& from, const double& to, std::vector<EclipseEvent>& events) {
+  EclipseEvent event;
+
+  for(int k = first; k <= last; k++) {
+    for(int quarter = 0; quarter <= 2; quarter += 2) {
+      ++candidates;
+
+      // Cheap rejection far from the nodes
+      if(!calculateNodeDistance(k, quarter))
+        continue;
+
+      ++survivors;
+
+      if(calculateEclipse(k, quarter, event) && event.jd >= from && event.jd < to)
+        events.push_back(event);
+    }
+  }
+}
+
+
+// ------- EclipseFinder Public Implementation
+
+void EclipseFinder::scan(const double& from, const double& to, std::vector<EclipseEvent>& events, const int& threads) {
+  if(to <= from)
+    return;
+
+  // Pad the lunation range by one either side; events are filtered by date
+  int first = int(std::floor((from - Lune::lunabase) / Lune::synmonth)) - 1;
+  int last = int(std::floor((to - Lune::lunabase) / Lune::synmonth)) + 1;
+  int count = last - first + 1;
+
+  int workers = threads < 1 ? 1 : threads;
+  if(workers > count)
+    workers = count;
+
+  if(workers == 1) {
+    scanLunations(first, last, from, to, events);
+    return;
+  }
+
+  // Give each worker a contiguous block of lunations and its own results so
+  // that concatenating the blocks keeps the events in order.
+  std::vector<EclipseFinder> finders(workers);
+  std::vector<std::vector<EclipseEvent>> results(workers);
+  std::vector<std::thread> pool;
+
+  int block = (count + workers - 1) / workers;
+
+  for(int i = 0; i < workers; i++) {
+    int a = first + i * block;
+    int b = std::min(a + block - 1, last);
+
+    pool.push_back(std::thread(&EclipseFinder::scanLunations, &finders[i], a, b, from, to, std::ref(results[i])));
+  }
+
+  for(int i = 0; i < workers; i++) {
+    pool[i].join();
+
+    candidates += finders[i].candidates;
+    survivors += finders[i].survivors;
+    events.insert(events.end(), results[i].begin(), results[i].end());
+  }
+}
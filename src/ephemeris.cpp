@@ -0,0 +1,354 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - ephemeris.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <cmath>
+
+// Local Includes
+#include <lune.hpp>
+#include <ephemeris.hpp>
+#include <luneconstants.hpp>
+
+
+// ------- Kepler Solver Constants
+
+// The second order series start is within e^3 / 2 of the root, and each
+// Newton step squares the error times e / (2 (1 - e)). For e <= 0.02 two
+// steps therefore reach the double precision limit.
+static const int kepler_iterations = 2;
+static const double kepler_warmlimit = 0.02;   // Largest mean anomaly step for a warm start, in radians (about a day)
+
+// Batch sine and cosine: reduction by pi/2 in two parts (Cody and Waite)
+// and Taylor series to the 15th and 16th powers, which stay below 1e-16
+// for |y| <= pi/4.
+static const double round_magic = 6755399441055744.0;   // 1.5 * 2^52 rounds to an integer
+static const double two_over_pi = 0.63661977236758134308;
+static const double pio2_hi = 1.57079632673412561417;
+static const double pio2_lo = 6.07710050650619224932e-11;
+
+
+// ------- Periodic Terms for the Moon's Distance
+//
+// Meeus, Astronomical Algorithms, table 47.A: multiples of D, M, M' and F
+// and the cosine coefficient in units of 0.001 km. Terms in M are scaled by
+// the decreasing eccentricity of the Earth's orbit.
+
+struct DistanceTerm {
+  signed char d, m, mp, f;
+  double r;
+};
+
+static const DistanceTerm distance_terms[] = {
+  { 0,  0,  1,  0, -20905355 }, { 2,  0, -1,  0, -3699111 }, { 2,  0,  0,  0, -2955968 },
+  { 0,  0,  2,  0,   -569925 }, { 0,  1,  0,  0,    48888 }, { 0,  0,  0,  2,    -3149 },
+  { 2,  0, -2,  0,    246158 }, { 2, -1, -1,  0,  -152138 }, { 2,  0,  1,  0,  -170733 },
+  { 2, -1,  0,  0,   -204586 }, { 0,  1, -1,  0,  -129620 }, { 1,  0,  0,  0,   108743 },
+  { 0,  1,  1,  0,    104755 }, { 2,  0,  0, -2,    10321 }, { 0,  0,  1,  2,        0 },
+  { 0,  0,  1, -2,     79661 }, { 4,  0, -1,  0,   -34782 }, { 0,  0,  3,  0,   -23210 },
+  { 4,  0, -2,  0,    -21636 }, { 2,  1, -1,  0,    24208 }, { 2,  1,  0,  0,    30824 },
+  { 1,  0, -1,  0,     -8379 }, { 1,  1,  0,  0,   -16675 }, { 2, -1,  1,  0,   -12831 },
+  { 2,  0,  2,  0,    -10445 }, { 4,  0,  0,  0,   -11650 }, { 2,  0, -3,  0,    14403 },
+  { 0,  1, -2,  0,     -7003 }, { 2,  0, -1,  2,        0 }, { 2, -1, -2,  0,    10056 },
+  { 1,  0,  1,  0,      6322 }, { 2, -2,  0,  0,    -9884 }, { 0,  1,  2,  0,     5751 },
+  { 0,  2,  0,  0,         0 }, { 2, -2, -1,  0,    -4950 }, { 2,  0,  1, -2,     4130 },
+  { 2,  0,  0,  2,         0 }, { 4, -1, -1,  0,    -3958 }, { 0,  0,  2,  2,        0 },
+  { 3,  0, -1,  0,      3258 }, { 2,  1,  1,  0,     2616 }, { 4, -1, -2,  0,    -1897 },
+  { 0,  2, -1,  0,     -2117 }, { 2,  2, -1,  0,     2354 }, { 2,  1, -2,  0,        0 },
+  { 2, -1,  0, -2,         0 }, { 4,  0,  1,  0,    -1423 }, { 0,  0,  4,  0,    -1117 },
+  { 4, -1,  0,  0,     -1571 }, { 1,  0, -2,  0,    -1739 }, { 2,  1,  0, -2,        0 },
+  { 0,  0,  2, -2,     -4421 }, { 1,  1,  1,  0,        0 }, { 3,  0, -2,  0,        0 },
+  { 4,  0, -3,  0,         0 }, { 2, -1,  2,  0,        0 }, { 0,  2,  1,  0,     1165 },
+  { 1,  1, -1,  0,         0 }, { 2,  0,  3,  0,        0 }, { 2,  0, -1, -2,     8752 }
+};
+
+static const double m_meandist = 385000.56;     // Mean distance of the Moon, in kilometers
+
+
+// ------- Useful mathematical functions
+
+static double fixedangle(double value) { return value - 360.0 * std::floor(value / 360.0); }
+static double todeg(double value) { return value * 180.0 / M_PI; }
+static double torad(double value) { return value * M_PI / 180.0; }
+
+
+static inline void calculateSinCos(const double& x, double& s, double& c) {
+  // Branchless so that the batch loops vectorize without a vector math
+  // library; exact for |x| below 2^20 * pi / 2.
+  double q = (x * two_over_pi + round_magic) - round_magic;
+  double y = (x - q * pio2_hi) - q * pio2_lo;
+  double y2 = y * y;
+
+  double ps = y + y * y2 * (-1.0 / 6 + y2 * (1.0 / 120 + y2 * (-1.0 / 5040 + y2 * (1.0 / 362880
+    + y2 * (-1.0 / 39916800 + y2 * (1.0 / 6227020800.0 + y2 * (-1.0 / 1307674368000.0)))))));
+  double pc = 1 + y2 * (-1.0 / 2 + y2 * (1.0 / 24 + y2 * (-1.0 / 720 + y2 * (1.0 / 40320
+    + y2 * (-1.0 / 3628800 + y2 * (1.0 / 479001600.0 + y2 * (-1.0 / 87178291200.0
+    + y2 * (1.0 / 20922789888000.0))))))));
+
+  // Quadrant q mod 4, as a remainder in -2 to 2
+  double r = q - 4 * ((q * 0.25 + round_magic) - round_magic);
+
+  bool swap = (r == 1 || r == -1);
+  double sb = swap ? pc : ps;
+  double cb = swap ? ps : pc;
+
+  s = (r < 0 || r > 1.5) ? -sb : sb;
+  c = (r > 0.5 || r < -1.5) ? -cb : cb;
+}
+
+
+// ------- Ephemeris Public Implementation
+
+double Ephemeris::calculateKepler(const double& m, const double& ecc) {
+  // Solve the Kepler equation
+  const double epsilon = 1e-12;
+
+  double m2 = torad(m);
+  double e = m2;
+
+  while(1) {
+    double delta = e - ecc * std::sin(e) - m2;
+    e -= delta / (1 - ecc * std::cos(e));
+
+    if(std::abs(delta) <= epsilon)
+      break;
+  }
+
+  return e;
+}
+
+
+double Ephemeris::calculateKeplerFixed(const double& m, const double& ecc) {
+  double m2 = torad(m);
+  double e = m2 + ecc * std::sin(m2) * (1 + ecc * std::cos(m2));
+
+  for(int i = 0; i < kepler_iterations; i++)
+    e -= (e - ecc * std::sin(e) - m2) / (1 - ecc * std::cos(e));
+
+  return e;
+}
+
+
+void Ephemeris::calculateKeplerBatch(const double *m, double *e, const std::size_t& count, const double& ecc) {
+  // Each step runs across every lane before the next. The loops carry no
+  // branches or library calls, so they vectorize with -fopenmp-simd.
+  const double rad = M_PI / 180.0;
+
+  #pragma omp simd
+  for(std::size_t i = 0; i < count; i++) {
+    double m2 = m[i] * rad, s, c;
+    calculateSinCos(m2, s, c);
+    e[i] = m2 + ecc * s * (1 + ecc * c);
+  }
+
+  for(int iter = 0; iter < kepler_iterations; iter++) {
+    #pragma omp simd
+    for(std::size_t i = 0; i < count; i++) {
+      double m2 = m[i] * rad, s, c;
+      calculateSinCos(e[i], s, c);
+      e[i] -= (e[i] - ecc * s - m2) / (1 - ecc * c);
+    }
+  }
+}
+
+
+double Ephemeris::calculateKeplerWarm(const double& m, const double& ecc) {
+  double m2 = torad(m);
+
+  // Cold start when there is no nearby previous solution
+  double step = m2 - k_anomaly;
+  step -= 2 * M_PI * std::floor((step + M_PI) / (2 * M_PI));
+
+  if(!k_valid || std::abs(step) > kepler_warmlimit) {
+    k_valid = true;
+    k_anomaly = m2;
+    k_solution = calculateKeplerFixed(m, ecc);
+    return k_solution;
+  }
+
+  // Continue from the previous solution along the unwrapped anomaly; a first
+  // order step and a single Newton step match the fixed solver.
+  double m3 = k_anomaly + step;
+  double e = k_solution + step / (1 - ecc * std::cos(k_solution));
+  e -= (e - ecc * std::sin(e) - m3) / (1 - ecc * std::cos(e));
+
+  k_anomaly = m2;
+  k_solution = e - (m3 - m2);
+
+  return e;
+}
+
+
+double Ephemeris::calculatePerturbedDistance(const double& jd) {
+  // Julian centuries from J2000
+  double t = (jd - j2000) / 36525.0;
+  double t2 = t * t;
+  double t3 = t2 * t;
+  double t4 = t3 * t;
+
+  // Mean elongation, Sun's and Moon's mean anomalies and argument of latitude
+  double d = torad(297.8501921 + 445267.1114034 * t - 0.0018819 * t2 + t3 / 545868.0 - t4 / 113065000.0);
+  double m = torad(357.5291092 + 35999.0502909 * t - 0.0001536 * t2 + t3 / 24490000.0);
+  double mp = torad(134.9633964 + 477198.8675055 * t + 0.0087414 * t2 + t3 / 69699.0 - t4 / 14712000.0);
+  double f = torad(93.2720950 + 483202.0175233 * t - 0.0036539 * t2 - t3 / 3526000.0 + t4 / 863310000.0);
+
+  double e = 1 - 0.002516 * t - 0.0000074 * t2;
+  double e2 = e * e;
+
+  double sum = 0;
+  for(std::size_t i = 0; i < sizeof(distance_terms) / sizeof(distance_terms[0]); i++) {
+    const DistanceTerm& term = distance_terms[i];
+    double r = term.r;
+
+    if(term.m == 1 || term.m == -1)
+      r *= e;
+    else if(term.m == 2 || term.m == -2)
+      r *= e2;
+
+    sum += r * std::cos(term.d * d + term.m * m + term.mp * mp + term.f * f);
+  }
+
+  return m_meandist + sum / 1000.0;
+}
+
+
+Ephemeris::Ephemeris() :
+  jday(0), k_mode(KEPLER_WARM), k_valid(false), k_anomaly(0), k_solution(0), s_anomaly(0), s_longitude(0), s_rate(0), s_dist(0), s_angdia(0),
+  m_longitude(0), m_latitude(0), m_elongation(0), m_rate(0), m_phase(0),
+  m_illuminated(0), m_age(0), m_dist(0), m_angdia(0), m_parallax(0) {}
+
+
+void Ephemeris::calculate(const double& jd) {
+  // Each term is differentiated alongside its value; rates are in degrees
+  // per day and the sine terms contribute amplitude * cos(x) * dx.
+  jday = jd;
+
+  //// SOLAR CALCULATIONS ////
+
+  // Calculate the date within the epoch
+  double day = jd - epoch;
+
+  // Mean anomaly of the Sun converted from perigee coordinates to epoch 1980
+  double m = fixedangle(s_mrate * day + s_elonge - s_elongp);
+  s_anomaly = m;
+
+  // Solve Kepler's equation
+  double ecc;
+  if(k_mode == KEPLER_WARM)
+    ecc = calculateKeplerWarm(m, s_eccent);
+  else if(k_mode == KEPLER_FIXED)
+    ecc = calculateKeplerFixed(m, s_eccent);
+  else
+    ecc = calculateKepler(m, s_eccent);
+  double denom = 1 - s_eccent * std::cos(ecc);
+
+  // True anomaly and its rate
+  double nu = 2 * todeg(std::atan(std::sqrt((1 + s_eccent) / (1 - s_eccent)) * std::tan(ecc / 2.0)));
+  s_rate = s_mrate * std::sqrt(1 - s_eccent * s_eccent) / (denom * denom);
+
+  // Suns's geometric eliptic longuitude
+  s_longitude = fixedangle(nu + s_elongp);
+
+  // Orbital distance factor
+  double f = (1 + s_eccent * std::cos(torad(nu))) / (1 - s_eccent * s_eccent);
+
+  // Distance to sun in km
+  s_dist = s_smax / f;
+  s_angdia = f * s_angsiz;
+
+
+  //// LUNAR CALCULATIONS ////
+
+  const double mrate = torad(s_mrate);
+
+  // Moon's mean longitude and mean anomaly
+  double ml = fixedangle(m_lrate * day + m_mlong);
+  double mm = fixedangle(ml - m_arate * day - m_mlongp);
+  double mmrate = m_lrate - m_arate;
+
+  // Evection
+  double ev_arg = torad(2 * (ml - s_longitude) - mm);
+  double evection = 1.2739 * std::sin(ev_arg);
+  double evrate = 1.2739 * std::cos(ev_arg) * torad(2 * (m_lrate - s_rate) - mmrate);
+
+  // Annual equation and correction term
+  double sinm = std::sin(torad(m));
+  double cosm = std::cos(torad(m));
+  double annual_eq = 0.1858 * sinm;
+  double a3 = 0.37 * sinm;
+  double aerate = 0.1858 * cosm * mrate;
+  double a3rate = 0.37 * cosm * mrate;
+
+  double mmp = mm + evection - annual_eq - a3;
+  double mmprate = mmrate + evrate - aerate - a3rate;
+
+  // Correction for the equation of the centre
+  double mec = 6.2886 * std::sin(torad(mmp));
+  double mecrate = 6.2886 * std::cos(torad(mmp)) * torad(mmprate);
+
+  // Another correction term
+  double a4 = 0.214 * std::sin(torad(2 * mmp));
+  double a4rate = 0.214 * std::cos(torad(2 * mmp)) * torad(2 * mmprate);
+
+  // Corrected longitude
+  double lp = ml + evection + mec - annual_eq + a4;
+  double lprate = m_lrate + evrate + mecrate - aerate + a4rate;
+
+  // Variation
+  double var_arg = torad(2 * (lp - s_longitude));
+  double variation = 0.6593 * std::sin(var_arg);
+  double varrate = 0.6593 * std::cos(var_arg) * torad(2 * (lprate - s_rate));
+
+  // True longitude
+  double llp = lp + variation;
+
+  // Corrected longitude of the node
+  double mn = fixedangle(m_mlnode - m_nrate * day) - 0.16 * sinm;
+
+  // Ecliptic longitude and latitude
+  double node_arg = torad(llp - mn);
+  m_longitude = fixedangle(todeg(std::atan2(std::sin(node_arg) * std::cos(torad(m_inc)), std::cos(node_arg))) + mn);
+  m_latitude = todeg(std::asin(std::sin(node_arg) * std::sin(torad(m_inc))));
+
+  // Age of the moon in degrees
+  m_elongation = fixedangle(llp - s_longitude);
+  m_rate = lprate + varrate - s_rate;
+
+
+  //// CACLUATE FINAL VARIABLES ////
+  m_phase = m_elongation / 360.0;
+  m_illuminated = (1 - std::cos(torad(m_elongation))) / 2.0;
+  m_age = Lune::synmonth * m_phase;
+
+  // Calculate distance of the moon from the centre of the earth
+  m_dist = (m_smax * (1 - m_mecc * m_mecc)) / (1 + m_mecc * std::cos(torad(mmp + mec)));
+
+  // Calculate the moon's angular diameter
+  m_angdia = m_angsiz * m_smax / m_dist;
+  m_parallax = m_parallax_a * m_smax / m_dist;
+}
@@ -27,40 +27,27 @@ DEALINGS IN THE SOFTWARE.
 
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#include <nlune.hpp>
+// C Library Includes
+#include <cmath>
 
+// C++ Library Includes
+#include <iostream>
 
-// ------- Astronomical Constants
+// Local Includes
+#include <lune.hpp>
+#include <lunesolver.hpp>
+#include <luneformat.hpp>
+#include <luneconstants.hpp>
 
-static const float epoch = 2444238.5;        // 1980 January 0.0
 
+// ------- Lunation Constants
 
-// ------- Constants Defining the Sun's apparent orbit
-
-static const float s_elonge = 278.833540;      // Ecliptic longitude of the Sun at epoch 1980.0
-static const float s_elongp = 282.596403;      // Ecliptic longitude of the Sun at perigee
-static const float s_eccent = 0.016718;        // Eccentricity of earths orbit
-static const float s_smax = 1.49585e8;      // Semi-major axis of Earth's orbit, in kilometers
-static const float s_angsiz = 0.533128;     // Sun's angular size, in degrees, at semi-major axis distance
-
-
-// ------- Elements of the Moon's Orbit
-
-static const float m_mlong = 64.975464;       // Moon's mean longitude at the epoch
-static const float m_mlongp = 349.383063;     // Mean longitude of the perigee at the epoch
-static const float m_mlnode = 151.950429;      // Mean longitude of the node at the epoch
-static const float m_inc = 5.145396;          // Inclination of the Moon's orbit
-static const float m_mecc = 0.054900;          // Eccentricity of the Moon's orbit
-static const float m_angsiz = 0.5181;         // Moon's angular size at distance a from Earth
-static const float m_smax = 384401.0;         // Semi-mojor axis of the Moon's orbit, in kilometers
-static const float m_parallax = 0.9507;       // Parallax at a distance a from Earth
-static const float synmonth = 29.53058868;   // Synodic month (new Moon to new Moon), in days
+const double Lune::synmonth = 29.53058868;   // Synodic month (new Moon to new Moon), in days
+const double Lune::lunabase = 2415020.75933; // Mean new moon of 1900 January, lunation k = 0
 static const float lunatbase = 2423436.0;    // Base date for E. W. Brown's numbered series of lunations (1923 January 16)
 
-
-// ------- Properties of the Earth
-
-static const float earthrad = 6378.16;       // Properties of the Earth
+// Brown's lunation 1 is the first new moon after lunatbase
+const int Lune::lunatoffset = int(std::floor((lunatbase - Lune::lunabase) / Lune::synmonth + 0.5)) - 1;
 
 
 // ------- Other static variables used
@@ -81,8 +68,7 @@ static const std::vector<std::string> phase_label {
   "Full Moon",
   "Waning Gibbous Moon",
   "Last Quarter Moon",
-  "Waning Crescent Moon",
-  "New Moon"
+  "Waning Crescent Moon"
 };
 
 
@@ -91,21 +77,87 @@ static const std::vector<std::string> phase_label {
 static float fixedangle(float value) { return value - 360.0 * std::floor(value / 360.0); }
 static float todeg(float value) { return value * 180.0 / M_PI; }
 static float torad(float value) { return value * M_PI / 180.0; }
-static float dsin(float value) { return std::sin(torad(value)); }
-static float dcos(float value) { return std::cos(torad(value)); }
+static double torad(double value) { return value * M_PI / 180.0; }
+static double dsin(double value) { return std::sin(torad(value)); }
+static double dcos(double value) { return std::cos(torad(value)); }
+
+
+static float calculateFunc(const float& v) {
+  return v*v*v - 2*v*v + 3;
+}
+
+
+static void bisect(const float& a, const float& b, float &c) {
+  c = a;
+  float d = a;
+  float e = b;
+
+  while((e - d) >= 0.01) {
+    c = (d + e) / 2;
+    if(calculateFunc(c) == 0.0)
+      break;
+    else if(calculateFunc(c) * calculateFunc(d) < 0)
+      e = c;
+    else
+      d = c;
+  }
+}
+
+
+// ------- Phase classification table
+//
+// The phase string changes at the bisected midpoint of each pair of
+// breakpoints. These depend only on constants, so they are bisected once
+// and a phase is classified through a table of equal bins. No two
+// thresholds share a bin, so one comparison settles the bin's class.
+
+static const int phase_bins = 256;
+
+struct PhaseTable {
+  float threshold[PHASE_CLASSES + 1];     // Ascending, with a sentinel
+  unsigned char bin[phase_bins + 1];      // Thresholds at or below each bin
+
+  PhaseTable() {
+    const float breakpoints[] = {
+      newmoon + precision,      // New Moon
+      firstmoon - precision,    // Waxing Crescent Moon
+      firstmoon + precision,    // First Quarter Moon
+      fullmoon - precision,     // Waxing Gibbous Moon
+      fullmoon + precision,     // Full Moon
+      lastmoon - precision,     // Waning Gibbous Moon
+      lastmoon + precision,     // Last Quarter Moon
+      nextmoon - precision,     // Waning Crescent Moon
+      nextmoon + precision,     // New Moon
+    };
+
+    for(int i = 0; i < PHASE_CLASSES; i++)
+      bisect(breakpoints[i], breakpoints[i + 1], threshold[i]);
+
+    threshold[PHASE_CLASSES] = 2.0;
+
+    for(int b = 0; b <= phase_bins; b++) {
+      int i = 0;
+      while(threshold[i] <= float(b) / phase_bins)
+        ++i;
+      bin[b] = i;
+    }
+  }
+};
+
+static const PhaseTable phase_table;
 
 
 // ------- Lune Private Implementation
 
-void Lune::calculatePhase() {
+void Lune::calculatePhase(const double& jd) {
 
   //// SOLAR CALCULATIONS ////
 
   // Calculate the date within the epoch
-  float day = jdate - epoch;
+  float day = jd - epoch;
 
   // Calculate the mean anomaly of the Sun
-  float n = fixedangle((350/365.2422) * day);
+  float n = fixedangle(s_mrate * day);
   // Convert from perigee coordinates to epoch 1980
   float m = fixedangle(n + s_elonge - s_elongp);
 
@@ -130,10 +182,10 @@ void Lune::calculatePhase() {
   //// LUNAR CALCULATIONS ////
 
   // Moon's mean longitude
-  float moon_longitude = fixedangle(13.1763966 * day + m_mlong);
+  float moon_longitude = fixedangle(m_lrate * day + m_mlong);
 
   // Moon's mean anomaly
-  float mm = fixedangle(moon_longitude - 0.1114041 * day - m_mlongp);
+  float mm = fixedangle(moon_longitude - m_arate * day - m_mlongp);
 
   // Moon's ascending node mean longitude
   float evection = 1.2739 * std::sin(torad(2*(moon_longitude - lambda_sun) - mm));
@@ -180,52 +232,32 @@ void Lune::calculatePhase() {
 }
 
 
-float Lune::calculateMeanPhase(const int& jdn, const float& k) {
-  // Obtain time in Julian Centuries from 1900 January 1, 12:00
-  int jcent;
-  calculateJulianFromDate(1, 1, 1900, jcent);
-
-  int delta = jdn - jcent;
-  int t = delta / 36525;
-
-  // Convenience Math
-  int t2 = t * t;    // Square
-  int t3 = t2 * t;   // Cube
-
-  return (
-        2415020.75933 + synmonth * k + 0.0001178 * t2 -
-        0.000000155 * t3 + 0.00033 * dsin(166.56 + 132.87 * t -
-        0.009173 * t2)
-      );
-}
-
-
-float Lune::calculateTruePhase(const float& k, const float& tphase) {
+double Lune::calculateTruePhase(const double& k, const double& tphase) {
   bool apcor = false;
 
   // Add phase to new moon time
-  float k2 = k + tphase;
+  double k2 = k + tphase;
 
   // Time in julian centuries from 1900 January 0.5
-  float t = k2 / 1236.85;
+  double t = k2 / 1236.85;
 
   // Convenience math
-  float t2 = t * t;   // Square
-  float t3 = t2 * t;  // cube
+  double t2 = t * t;   // Square
+  double t3 = t2 * t;  // cube
 
   // Mean time of phase
-  float pt = (2415020.75933 + synmonth * k2 + 0.0001178 * t2 -
+  double pt = (lunabase + synmonth * k2 + 0.0001178 * t2 -
       0.000000155 * t3 + 0.00033 * dsin(166.56 + 132.87 * t -
       0.009173 * t2));
 
   // Sun's mean anomaly
-  float m = 359.2242 + 29.10535608 * k2 - 0.0000333 * t2 - 0.00000347 * t3;
+  double m = 359.2242 + 29.10535608 * k2 - 0.0000333 * t2 - 0.00000347 * t3;
 
   // Moon's mean anomaly
-  float mprime = 306.0253 + 385.81691806 * k2 + 0.0107306 * t2 + 0.00001236 * t3;
+  double mprime = 306.0253 + 385.81691806 * k2 + 0.0107306 * t2 + 0.00001236 * t3;
 
   // Moon's argument of latitude
-  float f = 21.2964 + 390.67050646 * k2 - 0.0016528 * t2 - 0.00000239 * t3;
+  double f = calculateLatitudeArgument(k2);
 
   if((tphase < 0.01) || (std::abs(tphase - 0.5) < 0.01)) {
     // Corrections for new and full moon_longitude
@@ -286,108 +318,56 @@ float Lune::calculateTruePhase(const float& k, const float& tphase) {
 
 
 float Lune::calculateKepler(const float& m, const float& ecc) {
-  // Solve the Kepler equation
-  float epsilon = 1e-6;
-
+  // Solve the Kepler equation from the second order series start; for the
+  // Earth's eccentricity two Newton steps reach single precision, so the
+  // iteration count is fixed rather than data dependent.
   float m2 = torad(m);
-  float e = m2;
+  float e = m2 + ecc * std::sin(m2) * (1 + ecc * std::cos(m2));
 
-  while(1) {
-    float delta = e - ecc * std::sin(e) - m2;
-    e -= delta / (1 - ecc * std::cos(e));
-
-    if(std::abs(delta) <= epsilon)
-      break;
-  }
+  for(int i = 0; i < 2; i++)
+    e -= (e - ecc * std::sin(e) - m2) / (1 - ecc * std::cos(e));
 
   return e;
 }
 
 
 void Lune::calculatePhaseString() {
-  // Our values for the precise phases of the moon
-  float i;
-  const std::vector<float> breakpoints {
-    newmoon + precision,      // New Moon
-    firstmoon - precision,    // Waxing Crescent Moon
-    firstmoon + precision,    // First Quarter Moon
-    fullmoon - precision,     // Waxing Gibbous Moon
-    fullmoon + precision,     // Full Moon
-    lastmoon - precision,     // Waning Gibbous Moon
-    lastmoon + precision,     // Last Quarter Moon
-    nextmoon - precision,     // Waning Crescent Moon
-    nextmoon + precision,     // New Moon
-  };
-
-  // Calculate which string to display
-  for(unsigned int index = 0; index < breakpoints.size(); index++) {
-    if(index < 8) {
-      // Bisect our breakpoints to obtain the precise midpoint
-      bisect(breakpoints[index], breakpoints[index + 1], i);
-
-      // If it is less than the bisected value it's the phase we want
-      if(m_phase < i) {
-        m_string = phase_label[index];
-        return;
-      } else {
-        continue;
-      }
-    } else {
-      m_string = phase_label[index];
-    }
-  }
+  m_string = phase_label[calculatePhaseClass(m_phase)];
 }
 
 
 void Lune::calculateNextPhase() {
-  // Calculate our Julian Period
-  time_t adate;
-  calculateRelativeDate(&current_time, &adate, -45);
-
-  // Obtain relevant information
-  struct tm *timestamp = localtime(&adate);
-  int Y = timestamp->tm_year;
-  int M = timestamp->tm_mon + 1;
-
-  // Calculate our synmonth
-  int k1 = std::floor((Y + ((M - 1) * (1.0/12.0)) - 1900) * 12.3685);
-
-  // Get the julian date number
-  int ajdn;
-  calculateJulianFromTime(&adate, ajdn);
-
-  // Calculate the mean phase of the moon
-  int nt1 = calculateMeanPhase(ajdn, k1);
-  ajdn = nt1;
-
-  while(1) {
-    ajdn = ajdn + synmonth;
-    int k2 = k1 + 1;
-    int nt2 = calculateMeanPhase(ajdn, k2);
-    if(nt1 <= jdate && jdate < nt2)
-      break;
-    nt1 = nt2;
-    k1 = k2;
+  // Find the lunation containing our date directly from its number
+  int k1 = calculateLunation(jdate) + lunatoffset;
+
+  // Solve the exact instant of each event and round it to the Julian day
+  // number containing it
+  LuneSolver solver;
+  LuneEvent event;
+  solver.seekLunation(k1);
+
+  for(int i = 0; i < 5; i++) {
+    solver.next(event);
+
+    int jdn = std::floor(event.jd + 0.5);
+    m_phase_jd.push_back(event.jd);
+    m_phase_days.push_back(jdn);
+    m_phases.push_back(calculateGregorianString(jdn));
   }
+}
 
-  // Calculate the Julian Date number for each event
-
-  float newmoon_jdn = calculateTruePhase(k1, newmoon);
-  float firstmoon_jdn = calculateTruePhase(k1, firstmoon);
-  float fullmoon_jdn = calculateTruePhase(k1, fullmoon);
-  float lastmoon_jdn = calculateTruePhase(k1, lastmoon);
-  float nextmoon_jdn = calculateTruePhase(k1 + 1, newmoon);
 
-  m_phases.push_back(calculateGregorianString(newmoon_jdn));
-  m_phases.push_back(calculateGregorianString(firstmoon_jdn));
-  m_phases.push_back(calculateGregorianString(fullmoon_jdn));
-  m_phases.push_back(calculateGregorianString(lastmoon_jdn));
-  m_phases.push_back(calculateGregorianString(nextmoon_jdn));
+// ------- Private Helper functions
 
-}
 
+void Lune::calculateLune() {
+  // Everything below depends only on the Julian day number
+  calculatePhase(jdate);
+  calculatePhaseString();
+  calculateNextPhase();
 
-// ------- Private Helper functions
+  t_date = calculateGregorianString(jdate);
+}
 
 
 void Lune::calculateJulianFromDate(const int& dd, const int& mm, const int& yyyy, int& jdn) {
@@ -401,6 +381,16 @@ void Lune::calculateJulianFromDate(const int& dd, const int& mm, const int& yyyy
 }
 
 
+void Lune::calculateJulianFromOffset(const time_t& t, const long& offset, int& jdn) {
+  // Whole days since 1970 January 1 (JDN 2440588) at the given offset. Pure
+  // arithmetic, so unlike localtime this is safe to call from any thread.
+  long long secs = (long long)t + offset;
+  long long days = secs >= 0 ? secs / 86400 : -((-secs + 86399) / 86400);
+
+  jdn = int(days + 2440588);
+}
+
+
 void Lune::calculateJulianFromTime(time_t* t, int& jdn) {
   struct tm *timestamp;
   timestamp = localtime(t);
@@ -430,64 +420,102 @@ void Lune::calculateGregorian(const int& jdn, int& dd, int& mm, int& yyyy) {
 
 
 std::string Lune::calculateGregorianString(const int& jdn) {
-  // The Richards algorythm for converting Julian to Gregorian
-  int f = int(jdn) + 1401 + (((4 * int(jdn) + 274277) / 146097) * 3) / 4 + -38;
+  char buf[LUNE_DATE_SIZE];
+  return std::string(buf, LuneFormat::formatDate(jdn, buf));
+}
 
-  int e = 4 * f + 3;
-  int g = (e % 1461) / 4;
-  int h = 5 * g + 2;
 
-  int dd = (h % 153) / 5 + 1;
-  int mm = ((h /  153 + 2) % 12) + 1;
-  int yyyy = (e / 1461) - 4716 + (12 + 2 - mm) / 12;
+// ------- Lune Public Implementation
+
+
+Lune::Lune() {
+  // Get the current time stamp
+  time(&current_time);
 
-  std::string str = std::to_string(dd) + '/' + std::to_string(mm) + '/' + std::to_string(yyyy);
-  return str;
+  calculateJulianFromTime(&current_time, jdate);
+  calculateLune();
 }
 
 
-float Lune::calculateFunc(const float& v) {
-  return v*v*v - 2*v*v + 3;
+Lune::Lune(const time_t& t, const long& offset) {
+  current_time = t;
+
+  calculateJulianFromOffset(t, offset, jdate);
+  calculateLune();
 }
 
 
-void Lune::bisect(const float& a, const float& b, float &c) {
-  c = a;
-  float d = a;
-  float e = b;
+Lune::Lune(const double& jd) {
+  current_time = 0;
+  jdate = int(std::floor(jd + 0.5));
 
-  while((e - d) >= 0.01) {
-    c = (d + e) / 2;
-    if(calculateFunc(c) == 0.0)
-      break;
-    else if(calculateFunc(c) * calculateFunc(d) < 0)
-      e = c;
-    else
-      d = c;
-  }
+  calculatePhase(jd);
+}
+
+
+void Lune::calculateAt(const double& jd) {
+  calculatePhase(jd);
 }
 
 
-void Lune::calculateRelativeDate(time_t *tin, time_t *tout, const int& days) {
-  // Our day time constant
-  const time_t one_day = 24 * 60 * 60;
+double Lune::calculateLatitudeArgument(const double& k) {
+  // Time in julian centuries from 1900 January 0.5
+  double t = k / 1236.85;
+  double t2 = t * t;
 
-  // Calculate days from our start date
-  *tout = *tin + (one_day * days);
+  return 21.2964 + 390.67050646 * k - 0.0016528 * t2 - 0.00000239 * t2 * t;
 }
 
 
-// ------- Lune Public Implementation
+int Lune::calculatePhaseClass(const float& phase) {
+  // Clamping also sends NaN to the first bin, where it compares false
+  float p = std::fmin(std::fmax(phase, 0.0f), 1.0f);
+  int i = phase_table.bin[int(p * phase_bins)];
 
+  // Past the last threshold wraps around to the New Moon
+  return (i + (phase >= phase_table.threshold[i])) % PHASE_CLASSES;
+}
 
-Lune::Lune() {
-  // Get the current time stamp
-  time(&current_time);
 
-  calculateJulianFromTime(&current_time, jdate);
-  calculatePhase();
-  calculatePhaseString();
-  calculateNextPhase();
+const std::string& Lune::getPhaseLabel(const int& phase_class) {
+  return phase_label[phase_class];
+}
 
-  t_date = calculateGregorianString(jdate);
+
+int Lune::calculateLunation(const double& jd) {
+  // Estimate from the mean synodic month, then correct by at most one
+  // lunation against the solved new moons either side.
+  LuneSolver solver;
+  int k = std::floor((jd - lunabase) / synmonth);
+
+  if(solver.solvePhase(k, 0) > jd)
+    --k;
+  else if(solver.solvePhase(k + 1, 0) <= jd)
+    ++k;
+
+  return k - lunatoffset;
+}
+
+
+void Lune::calculateLunationPhases(const int& lunation, double *jd) {
+  calculateLunationRange(lunation, 1, jd);
+}
+
+
+void Lune::calculateLunationRange(const int& first, const std::size_t& count, double *jd) {
+  // Consecutive events share their brackets through the solver stream
+  LuneSolver solver;
+  LuneEvent event;
+  solver.seekLunation(first + lunatoffset);
+
+  for(std::size_t i = 0; i < count * 4; i++) {
+    solver.next(event);
+    jd[i] = event.jd;
+  }
+}
+
+
+void Lune::calculateLunationBatch(const double *jd, const std::size_t& count, int *lunation) {
+  for(std::size_t i = 0; i < count; i++)
+    lunation[i] = calculateLunation(jd[i]);
 }
@@ -0,0 +1,131 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - lunecalendar.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <cstring>
+
+// Local Includes
+#include <lunecalendar.hpp>
+#include <luneformat.hpp>
+
+
+// ------- Calendar Constants
+
+static const double unixepoch = 2440587.5;     // 1970 January 1.0
+static const double firstdate = 1721059.5;     // 0000 January 1.0, the first four digit year
+static const double lastdate = 5373484.5;      // 10000 January 1.0
+
+static const char *calendar_header =
+  "BEGIN:VCALENDAR\r\n"
+  "VERSION:2.0\r\n"
+  "PRODID:-//nLune//Lunar Phases//EN\r\n"
+  "CALSCALE:GREGORIAN\r\n"
+  "METHOD:PUBLISH\r\n"
+  "X-WR-CALNAME:Moon Phases\r\n";
+
+static const char *calendar_footer = "END:VCALENDAR\r\n";
+
+static const char *event_label[] {
+  "New Moon",
+  "First Quarter Moon",
+  "Full Moon",
+  "Last Quarter Moon"
+};
+
+
+// ------- Useful formatting functions
+
+static char* append(char* buf, const char* str) {
+  std::size_t len = std::strlen(str);
+  std::memcpy(buf, str, len);
+  return buf + len;
+}
+
+
+// ------- LuneCalendar Private Implementation
+
+std::size_t LuneCalendar::formatEvent(const LuneEvent& event, char* buf) {
+  char *p = buf;
+
+  p = append(p, "BEGIN:VEVENT\r\nUID:");
+  p += LuneFormat::formatInteger(event.lunation, p);
+  *p++ = '-';
+  p += LuneFormat::formatInteger(event.quarter, p);
+  p = append(p, "@nlune\r\nDTSTAMP:");
+  p = append(p, dtstamp);
+  p = append(p, "\r\nDTSTART:");
+  p += LuneFormat::formatISODateTime(event.jd, p, true);
+  p = append(p, "\r\nSUMMARY:");
+  p = append(p, event_label[event.quarter]);
+  p = append(p, "\r\nTRANSP:TRANSPARENT\r\nEND:VEVENT\r\n");
+
+  return p - buf;
+}
+
+
+// ------- LuneCalendar Public Implementation
+
+LuneCalendar::LuneCalendar() {
+  time_t stamp;
+  time(&stamp);
+
+  // Every event shares the generation time
+  LuneFormat::formatISODateTime(unixepoch + stamp / 86400.0, dtstamp, true);
+}
+
+
+long LuneCalendar::write(std::ostream& out, const double& from, const double& to) {
+  char buf[256];
+  long count = 0;
+
+  out.write(calendar_header, std::strlen(calendar_header));
+
+  // DATE-TIME values have four digit years, so the range is clipped to them
+  double a = from < firstdate ? firstdate : from;
+  double b = to > lastdate ? lastdate : to;
+
+  if(b > a) {
+    LuneEvent event;
+    solver.seek(a);
+
+    while(1) {
+      solver.next(event);
+      if(event.jd >= b)
+        break;
+
+      out.write(buf, formatEvent(event, buf));
+      ++count;
+    }
+  }
+
+  out.write(calendar_footer, std::strlen(calendar_footer));
+  out.flush();
+
+  return count;
+}
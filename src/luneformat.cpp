@@ -0,0 +1,266 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - luneformat.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Local Includes
+#include <lune.hpp>
+#include <luneformat.hpp>
+
+
+// ------- Format Constants
+
+static const char digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static const long long powers[] = {
+  1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL
+};
+
+static const double fixed_limit = 1e15;         // Scaled values stay well inside a double's integers
+static const int jdn_limit = 536000000;        // Richards' arithmetic stays within an int
+
+
+// ------- Useful formatting functions
+
+static char* appendPair(char* buf, const unsigned& value) {
+  std::memcpy(buf, digit_pairs + 2 * value, 2);
+  return buf + 2;
+}
+
+
+static char* appendUnsigned(char* buf, unsigned long long value, const int& width = 1) {
+  // Fill from the right of a scratch buffer, then copy out
+  char tmp[24];
+  char *end = tmp + sizeof(tmp);
+  char *p = end;
+
+  while(value >= 100) {
+    p -= 2;
+    std::memcpy(p, digit_pairs + 2 * (value % 100), 2);
+    value /= 100;
+  }
+
+  if(value >= 10) {
+    p -= 2;
+    std::memcpy(p, digit_pairs + 2 * value, 2);
+  } else {
+    *--p = char('0' + value);
+  }
+
+  while(end - p < width)
+    *--p = '0';
+
+  std::memcpy(buf, p, end - p);
+  return buf + (end - p);
+}
+
+
+static void calculateDate(const int& jdn, int& dd, int& mm, int& yyyy) {
+  // Clamp to the days the conversion handles, Julian day number 0 onwards,
+  // so that every field fits its buffer
+  Lune::calculateGregorian(jdn < 0 ? 0 : (jdn > jdn_limit ? jdn_limit : jdn), dd, mm, yyyy);
+}
+
+
+static char* appendYear(char* buf, const int& yyyy) {
+  if(yyyy >= 0 && yyyy <= 9999) {
+    buf = appendPair(buf, yyyy / 100);
+    return appendPair(buf, yyyy % 100);
+  }
+
+  *buf++ = yyyy < 0 ? '-' : '+';
+  return appendUnsigned(buf, yyyy < 0 ? 0ULL - (unsigned long long)yyyy : yyyy, 4);
+}
+
+
+static char* appendISODate(char* buf, const int& dd, const int& mm, const int& yyyy) {
+  buf = appendYear(buf, yyyy);
+  *buf++ = '-';
+  buf = appendPair(buf, mm);
+  *buf++ = '-';
+  return appendPair(buf, dd);
+}
+
+
+// ------- LuneFormat Public Implementation
+
+std::size_t LuneFormat::formatDate(const int& jdn, char* buf) {
+  int dd, mm, yyyy;
+  calculateDate(jdn, dd, mm, yyyy);
+
+  char *p = appendUnsigned(buf, dd);
+  *p++ = '/';
+  p = appendUnsigned(p, mm);
+  *p++ = '/';
+  p += formatInteger(yyyy, p);
+
+  *p = '\0';
+  return p - buf;
+}
+
+
+std::size_t LuneFormat::formatISODate(const int& jdn, char* buf) {
+  int dd, mm, yyyy;
+  calculateDate(jdn, dd, mm, yyyy);
+
+  char *p = appendISODate(buf, dd, mm, yyyy);
+
+  *p = '\0';
+  return p - buf;
+}
+
+
+std::size_t LuneFormat::formatISODateTime(const double& jd, char* buf, const bool& basic) {
+  // Round to the nearest second before splitting into day and time so the
+  // seconds never carry into the next day.
+  double seconds = std::floor((jd + 0.5) * 86400.0 + 0.5);
+  double days = std::floor(seconds / 86400.0);
+
+  // Dates out of range, or NaN, clamp to midnight of the nearest day
+  bool valid = days >= 0 && days <= jdn_limit;
+  int jdn = int(std::fmin(std::fmax(days, 0.0), jdn_limit));
+  int sod = valid ? int(seconds - days * 86400.0) : 0;
+
+  int dd, mm, yyyy;
+  calculateDate(jdn, dd, mm, yyyy);
+
+  char *p = buf;
+
+  if(basic) {
+    p = appendYear(p, yyyy);
+    p = appendPair(p, mm);
+    p = appendPair(p, dd);
+    *p++ = 'T';
+    p = appendPair(p, sod / 3600);
+    p = appendPair(p, (sod / 60) % 60);
+    p = appendPair(p, sod % 60);
+  } else {
+    p = appendISODate(p, dd, mm, yyyy);
+    *p++ = 'T';
+    p = appendPair(p, sod / 3600);
+    *p++ = ':';
+    p = appendPair(p, (sod / 60) % 60);
+    *p++ = ':';
+    p = appendPair(p, sod % 60);
+  }
+
+  *p++ = 'Z';
+  *p = '\0';
+  return p - buf;
+}
+
+
+std::size_t LuneFormat::formatInteger(const long long& value, char* buf) {
+  char *p = buf;
+
+  if(value < 0)
+    *p++ = '-';
+
+  // Negate as unsigned so the most negative value survives
+  p = appendUnsigned(p, value < 0 ? 0ULL - (unsigned long long)value : value);
+
+  *p = '\0';
+  return p - buf;
+}
+
+
+std::size_t LuneFormat::formatFixed(const double& value, const int& decimals, char* buf) {
+  int d = decimals < 0 ? 0 : (decimals > 9 ? 9 : decimals);
+
+  // Scale to an integer count of the last decimal and split it
+  double scaled = std::abs(value) * powers[d];
+
+  if(!(scaled < fixed_limit))
+    return std::snprintf(buf, LUNE_FIXED_SIZE, "%.*e", d, value);
+
+  unsigned long long units = (unsigned long long)(scaled + 0.5);
+  unsigned long long whole = units / powers[d];
+
+  char *p = buf;
+
+  if(value < 0 && units > 0)
+    *p++ = '-';
+
+  p = appendUnsigned(p, whole);
+
+  if(d > 0) {
+    *p++ = '.';
+    p = appendUnsigned(p, units - whole * powers[d], d);
+  }
+
+  *p = '\0';
+  return p - buf;
+}
+
+
+void LuneFormat::formatISODates(const int *jdn, const std::size_t& count, char *out) {
+  // Convert a block of dates before formatting any of them, with Richards'
+  // arithmetic from Lune::calculateGregorian inlined so the conversion loop
+  // has no calls and vectorizes
+  const std::size_t block = 256;
+  int dd[block], mm[block], yyyy[block];
+
+  for(std::size_t first = 0; first < count; first += block) {
+    std::size_t n = count - first < block ? count - first : block;
+
+    #pragma omp simd
+    for(std::size_t i = 0; i < n; i++) {
+      // Clamped as calculateDate does
+      int j = jdn[first + i];
+      j = j < 0 ? 0 : (j > jdn_limit ? jdn_limit : j);
+
+      int f = j + 1401 + (((4 * j + 274277) / 146097) * 3) / 4 - 38;
+      int e = 4 * f + 3;
+      int g = (e % 1461) / 4;
+      int h = 5 * g + 2;
+
+      dd[i] = (h % 153) / 5 + 1;
+      mm[i] = ((h / 153 + 2) % 12) + 1;
+      yyyy[i] = (e / 1461) - 4716 + (12 + 2 - mm[i]) / 12;
+    }
+
+    for(std::size_t i = 0; i < n; i++) {
+      char *p = appendISODate(out + (first + i) * LUNE_ISO_DATE_SIZE, dd[i], mm[i], yyyy[i]);
+      *p = '\0';
+    }
+  }
+}
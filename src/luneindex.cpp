@@ -0,0 +1,194 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - luneindex.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <cmath>
+
+// C++ Library Includes
+#include <algorithm>
+#include <thread>
+
+// Local Includes
+#include <luneindex.hpp>
+
+
+// ------- LuneIndex Private Implementation
+
+void LuneIndex::calculateRecords(const int& first, const int& last) {
+  // Only the phase quantities are calculated, here and for each day
+  Lune moon(double(i_first + first));
+
+  for(int i = first; i < last; i++) {
+    moon.calculateAt(i_first + i);
+
+    r_illuminated[i] = moon.getIlluminated();
+    r_distance[i] = moon.getDistance();
+    r_angdia[i] = moon.getAngularDiameter();
+    r_class[i] = Lune::calculatePhaseClass(moon.getPhase());
+  }
+}
+
+
+void LuneIndex::calculatePrefix() {
+  p_illuminated.assign(i_days + 1, 0);
+  p_distance.assign(i_days + 1, 0);
+  p_angdia.assign(i_days + 1, 0);
+  p_class.assign((i_days + 1) * PHASE_CLASSES, 0);
+
+  for(int i = 0; i < i_days; i++) {
+    p_illuminated[i + 1] = p_illuminated[i] + r_illuminated[i];
+    p_distance[i + 1] = p_distance[i] + r_distance[i];
+    p_angdia[i + 1] = p_angdia[i] + r_angdia[i];
+
+    int *row = &p_class[i * PHASE_CLASSES];
+    int *next = row + PHASE_CLASSES;
+
+    for(int c = 0; c < PHASE_CLASSES; c++)
+      next[c] = row[c];
+    ++next[r_class[i]];
+  }
+}
+
+
+bool LuneIndex::calculateWindow(const int& from, const int& to, int& a, int& b) {
+  // Clip to the indexed days and convert to prefix rows
+  a = std::min(std::max(from - i_first, 0), i_days);
+  b = std::min(std::max(to - i_first, 0), i_days);
+
+  return b > a;
+}
+
+
+double LuneIndex::calculateMean(const std::vector<double>& prefix, const int& from, const int& to) {
+  int a, b;
+  if(!calculateWindow(from, to, a, b))
+    return NAN;
+
+  return (prefix[b] - prefix[a]) / (b - a);
+}
+
+
+// ------- LuneIndex Public Implementation
+
+LuneIndex::LuneIndex() : i_first(0), i_days(0) {
+  calculatePrefix();
+}
+
+
+void LuneIndex::build(const int& first, const int& days, const int& threads) {
+  i_first = first;
+  i_days = days < 0 ? 0 : days;
+
+  r_illuminated.resize(i_days);
+  r_distance.resize(i_days);
+  r_angdia.resize(i_days);
+  r_class.resize(i_days);
+
+  int workers = threads < 1 ? 1 : threads;
+  if(workers > i_days)
+    workers = i_days;
+
+  if(workers <= 1) {
+    calculateRecords(0, i_days);
+  } else {
+    // Each worker fills its own contiguous block of the records
+    std::vector<std::thread> pool;
+    int block = (i_days + workers - 1) / workers;
+
+    for(int i = 0; i < workers; i++) {
+      int a = std::min(i * block, i_days);
+      int b = std::min(a + block, i_days);
+
+      pool.push_back(std::thread(&LuneIndex::calculateRecords, this, a, b));
+    }
+
+    for(int i = 0; i < workers; i++)
+      pool[i].join();
+  }
+
+  calculatePrefix();
+}
+
+
+double LuneIndex::getMeanIlluminated(const int& from, const int& to) {
+  return calculateMean(p_illuminated, from, to);
+}
+
+
+double LuneIndex::getMeanDistance(const int& from, const int& to) {
+  return calculateMean(p_distance, from, to);
+}
+
+
+double LuneIndex::getMeanAngularDiameter(const int& from, const int& to) {
+  return calculateMean(p_angdia, from, to);
+}
+
+
+int LuneIndex::getClassCount(const int& from, const int& to, const int& phase_class) {
+  int a, b;
+  if(!calculateWindow(from, to, a, b))
+    return 0;
+
+  return p_class[b * PHASE_CLASSES + phase_class] - p_class[a * PHASE_CLASSES + phase_class];
+}
+
+
+void LuneIndex::getClassCounts(const int& from, const int& to, int *counts) {
+  int a, b;
+  bool window = calculateWindow(from, to, a, b);
+
+  for(int c = 0; c < PHASE_CLASSES; c++)
+    counts[c] = window ? p_class[b * PHASE_CLASSES + c] - p_class[a * PHASE_CLASSES + c] : 0;
+}
+
+
+int LuneIndex::findClass(const int& from, const int& phase_class) {
+  int a, b;
+  if(!calculateWindow(from, i_first + i_days, a, b))
+    return -1;
+
+  // The smallest row past a whose count exceeds the count at a ends on the
+  // first matching day
+  int base = p_class[a * PHASE_CLASSES + phase_class];
+  if(p_class[b * PHASE_CLASSES + phase_class] == base)
+    return -1;
+
+  int lo = a + 1, hi = b;
+  while(lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+
+    if(p_class[mid * PHASE_CLASSES + phase_class] > base)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return i_first + lo - 1;
+}
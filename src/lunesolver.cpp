@@ -0,0 +1,211 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - lunesolver.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <cmath>
+
+// Local Includes
+#include <lune.hpp>
+#include <lunesolver.hpp>
+
+
+// ------- Solver Constants
+
+static const double tolerance = 0.5 / 86400.0; // Half a second, in days
+static const double margin = 1.5;              // Bracket half width around an estimate, in days
+static const double span = 10.0;               // Upper bracket after a previous event, in days
+static const double curvature = 0.1;           // Bound on |f''/2f'| of the elongation, per day, doubled
+static const int maxiter = 50;
+
+
+// ------- Useful mathematical functions
+
+static double wrapangle(double value) { return value - 360.0 * std::floor((value + 180.0) / 360.0); }
+
+
+// ------- LuneSolver Private Implementation
+
+double LuneSolver::calculateEstimate(const int& k, const int& quarter) {
+  // The true phase series places the event within minutes of the root
+  return Lune::calculateTruePhase(k, quarter / 4.0);
+}
+
+
+double LuneSolver::solve(const double& target, double lo, double hi, double t) {
+  // The elongation rises monotonically through the target inside [lo, hi]
+  // so the bracket ends never need to be evaluated.
+  for(int iter = 0; iter < maxiter; iter++) {
+    eph.calculate(t);
+    ++evaluations;
+
+    double delta = wrapangle(eph.getElongation() - target);
+
+    if(delta < 0)
+      lo = t;
+    else
+      hi = t;
+
+    double step = delta / eph.getElongationRate();
+    double tn = t - step;
+
+    // Newton's error after this step is at most curvature * step^2, so a
+    // small enough step is accepted without evaluating its result
+    if(curvature * step * step < tolerance)
+      return tn;
+
+    // Keep the iteration inside the bracket
+    if(tn <= lo || tn >= hi)
+      tn = (lo + hi) / 2.0;
+
+    if((hi - lo) < tolerance)
+      return tn;
+
+    t = tn;
+  }
+
+  return t;
+}
+
+
+void LuneSolver::advance(LuneEvent& event) {
+  double estimate = calculateEstimate(s_lunation, s_quarter);
+  double target = s_quarter * 90.0;
+
+  // The ephemeris root differs from the true phase estimate by an offset
+  // which changes slowly from one lunation to the next. Start from the
+  // estimate corrected by this quarter's last offset and its drift.
+  double start = estimate;
+
+  if(s_known[s_quarter] > 1)
+    start += 2 * s_offset[s_quarter][0] - s_offset[s_quarter][1];
+  else if(s_known[s_quarter] > 0)
+    start += s_offset[s_quarter][0];
+
+  if(s_linked)
+    event.jd = solve(target, s_previous, s_previous + span, start);
+  else
+    event.jd = solve(target, estimate - margin, estimate + margin, start);
+
+  s_offset[s_quarter][1] = s_offset[s_quarter][0];
+  s_offset[s_quarter][0] = event.jd - estimate;
+  ++s_known[s_quarter];
+
+  event.lunation = s_lunation;
+  event.quarter = s_quarter;
+
+  // Advance the stream
+  s_previous = event.jd;
+  s_linked = true;
+
+  if(++s_quarter > 3) {
+    s_quarter = 0;
+    ++s_lunation;
+  }
+}
+
+
+// ------- LuneSolver Public Implementation
+
+LuneSolver::LuneSolver() :
+  s_lunation(0), s_quarter(0), s_linked(false), s_previous(0), s_from(0), evaluations(0) {
+  forget();
+}
+
+
+double LuneSolver::solvePhase(const int& k, const int& quarter) {
+  double estimate = calculateEstimate(k, quarter);
+  return solve(quarter * 90.0, estimate - margin, estimate + margin, estimate);
+}
+
+
+void LuneSolver::forget() {
+  for(int q = 0; q < 4; q++) {
+    s_offset[q][0] = s_offset[q][1] = 0;
+    s_known[q] = 0;
+  }
+}
+
+
+void LuneSolver::seek(const double& jd) {
+  // Step back one lunation from the mean estimate, then advance over the
+  // true phase estimates until we reach the requested date.
+  int k = int(std::floor((jd - Lune::lunabase) / Lune::synmonth)) - 1;
+  int quarter = 0;
+
+  while(calculateEstimate(k, quarter) < jd - margin) {
+    if(++quarter > 3) {
+      quarter = 0;
+      ++k;
+    }
+  }
+
+  s_lunation = k;
+  s_quarter = quarter;
+  s_linked = false;
+  s_from = jd;
+  forget();
+}
+
+
+void LuneSolver::seekLunation(const int& k) {
+  // Start at the new moon of lunation k
+  s_lunation = k;
+  s_quarter = 0;
+  s_linked = false;
+  s_from = -HUGE_VAL;
+  forget();
+}
+
+
+void LuneSolver::next(LuneEvent& event) {
+  // Skip any event which still falls before the seek date
+  do {
+    advance(event);
+  } while(event.jd < s_from);
+}
+
+
+void LuneSolver::solveRange(const double& from, const double& to, std::vector<LuneEvent>& events) {
+  if(to <= from)
+    return;
+
+  // Roughly four events per synodic month
+  events.reserve(events.size() + std::size_t((to - from) / Lune::synmonth * 4.0) + 4);
+
+  LuneEvent event;
+  seek(from);
+
+  while(1) {
+    next(event);
+    if(event.jd >= to)
+      break;
+
+    events.push_back(event);
+  }
+}
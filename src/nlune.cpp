@@ -32,6 +32,13 @@ DEALINGS IN THE SOFTWARE.
 // ------- Static Constants
 
 static const float moon_aspect = 0.5;
+static const std::vector<std::string> event_label {
+  "New Moon",
+  "First Quarter Moon",
+  "Full Moon",
+  "Last Quarter Moon",
+  "New Moon"
+};
 static const std::vector<std::string> moon_ascii {
     "             .----------.            ",
     "         .--'   o    .   `--.        ",
@@ -56,6 +63,13 @@ static const std::vector<std::string> moon_ascii {
 
 // ------- Public nLune Implementation
 
+void nLune::setZones(const std::vector<nLuneZone>& z) {
+  // Open on the multi-zone view whenever zones are configured
+  zones = z;
+  show_zones = !zones.empty();
+}
+
+
 void nLune::initialize() {
   // Initialize and configure ncurses
   initscr();
@@ -98,8 +112,13 @@ void nLune::execute() {
 
     // Write the relevant information to the back buffer
     printBorder();
-    printData();
-    printMoon();
+
+    if(show_zones) {
+      printZones();
+    } else {
+      printData();
+      printMoon();
+    }
 
     int opt = getch();
 
@@ -107,6 +126,9 @@ void nLune::execute() {
       case CTRL_KEY('x'):
         initialized = false;
         break;
+      case CTRL_KEY('t'):
+        show_zones = !show_zones && !zones.empty();
+        break;
       default:
         break;
     }
@@ -139,7 +161,7 @@ void nLune::printBorder() {
 
   // Draw our banner and footer
   const std::string banner = " | nLune - 0.01-BETA | ";
-  const std::string footer = "[ PRESS CTRL + X TO EXIT ]";
+  const std::string footer = zones.empty() ? "[ PRESS CTRL + X TO EXIT ]" : "[ PRESS CTRL + X TO EXIT | CTRL + T FOR ZONES ]";
 
   mvwprintw(stdscr, min_y - 1, max_x - banner.size(), banner.c_str());
   mvwprintw(stdscr, max_y, min_x + 1, footer.c_str());
@@ -151,29 +173,31 @@ void nLune::printData() {
   if(!initialized)
     return;
 
-  // Format our data for output
-  std::vector<std::string> phases = moon.getNextPhases();
-  std::string date = std::string("Date: ") + moon.getDate();
-  std::string jdate = std::string("Julian Date: ") + std::to_string(moon.getJulianDate());
-  std::string cphase = moon.getPhaseString();
-  std::string nmoon = std::string("New Moon: ") + phases[0];
-  std::string fstmoon = std::string("First Quarter Moon: ") + phases[1];
-  std::string fmoon = std::string("Full Moon: ") + phases[2];
-  std::string lstmoon = std::string("Last Quarter Moon: ") + phases[3];
-  std::string nxtmoon = std::string("Next New Moon: ") + phases[4];
+  // Each line is written as its label followed by its value, so only the
+  // Julian date needs formatting
+  const std::vector<std::string>& phases = moon.getNextPhases();
+  char jdate[LUNE_INTEGER_SIZE];
+  LuneFormat::formatInteger(moon.getJulianDate(), jdate);
 
   // Print the data to screen
   wattron(stdscr, COLOR_PAIR(2));
 
-  mvwprintw(stdscr, min_y + 2, min_x + 1, cphase.c_str());
-  mvwprintw(stdscr, min_y + 3, min_x + 1, date.c_str());
-  mvwprintw(stdscr, min_y + 4, min_x + 1, jdate.c_str());
-
-  mvwprintw(stdscr, min_y + 7, min_x + 1, nmoon.c_str());
-  mvwprintw(stdscr, min_y + 9, min_x + 1, fstmoon.c_str());
-  mvwprintw(stdscr, min_y + 11, min_x + 1, fmoon.c_str());
-  mvwprintw(stdscr, min_y + 13, min_x + 1, lstmoon.c_str());
-  mvwprintw(stdscr, min_y + 15, min_x + 1, nxtmoon.c_str());
+  mvwaddstr(stdscr, min_y + 2, min_x + 1, moon.getPhaseString().c_str());
+  mvwaddstr(stdscr, min_y + 3, min_x + 1, "Date: ");
+  waddstr(stdscr, moon.getDate().c_str());
+  mvwaddstr(stdscr, min_y + 4, min_x + 1, "Julian Date: ");
+  waddstr(stdscr, jdate);
+
+  mvwaddstr(stdscr, min_y + 7, min_x + 1, "New Moon: ");
+  waddstr(stdscr, phases[0].c_str());
+  mvwaddstr(stdscr, min_y + 9, min_x + 1, "First Quarter Moon: ");
+  waddstr(stdscr, phases[1].c_str());
+  mvwaddstr(stdscr, min_y + 11, min_x + 1, "Full Moon: ");
+  waddstr(stdscr, phases[2].c_str());
+  mvwaddstr(stdscr, min_y + 13, min_x + 1, "Last Quarter Moon: ");
+  waddstr(stdscr, phases[3].c_str());
+  mvwaddstr(stdscr, min_y + 15, min_x + 1, "Next New Moon: ");
+  waddstr(stdscr, phases[4].c_str());
 
   wattroff(stdscr, COLOR_PAIR(2));
 }
@@ -234,6 +258,94 @@ void nLune::printMoon() {
 }
 
 
+void nLune::printZones() {
+  if(!initialized)
+    return;
+
+  calculateZones();
+
+  wattron(stdscr, COLOR_PAIR(2));
+  mvwprintw(stdscr, min_y + 2, min_x + 1, "%-14s %-17s %-21s %s", "Zone", "Local Time", "Phase", "Next Event");
+
+  for(unsigned int i = 0; i < zones.size(); i++) {
+    int row = min_y + 4 + i;
+    if(row >= max_y - 1)
+      break;
+
+    Lune& zmoon = zone_moons[zone_index[i]];
+
+    // Local time of day at this zone's offset
+    long long secs = (long long)zone_time + zones[i].offset;
+    int sod = int(((secs % 86400) + 86400) % 86400);
+
+    char local[18];
+    std::snprintf(local, sizeof(local), "%s %02d:%02d", zmoon.getDate().c_str(), sod / 3600, (sod / 60) % 60);
+
+    // The first event after the local date. Event instants are UT, so each
+    // is moved to this zone's offset the same way the local date was.
+    std::string next;
+    const std::vector<double>& instants = zmoon.getNextPhaseInstants();
+
+    for(unsigned int e = 0; e < instants.size(); e++) {
+      int jdn = int(std::floor(instants[e] + 0.5 + zones[i].offset / 86400.0));
+
+      if(jdn > zmoon.getJulianDate()) {
+        char date[LUNE_DATE_SIZE];
+        LuneFormat::formatDate(jdn, date);
+
+        next = event_label[e] + ": " + date;
+        break;
+      }
+    }
+
+    mvwprintw(stdscr, row, min_x + 1, "%-14.14s %-17s %-21s %s", zones[i].label.c_str(), local, zmoon.getPhaseString().c_str(), next.c_str());
+  }
+
+  wattroff(stdscr, COLOR_PAIR(2));
+}
+
+
+void nLune::calculateZones() {
+  // Zones on the same Julian day share one set of results, and each
+  // distinct day is computed on its own thread. The results are kept until
+  // the local day of some zone changes.
+  time(&zone_time);
+
+  std::vector<int> days;
+  std::vector<long> offsets;
+  zone_index.resize(zones.size());
+
+  for(unsigned int i = 0; i < zones.size(); i++) {
+    int jdn;
+    Lune::calculateJulianFromOffset(zone_time, zones[i].offset, jdn);
+
+    unsigned int d = 0;
+    while(d < days.size() && days[d] != jdn)
+      ++d;
+
+    if(d == days.size()) {
+      days.push_back(jdn);
+      offsets.push_back(zones[i].offset);
+    }
+
+    zone_index[i] = d;
+  }
+
+  if(days == zone_days && zone_moons.size() == days.size())
+    return;
+
+  zone_days = days;
+
+  std::vector<std::future<Lune>> results;
+  for(unsigned int d = 0; d < days.size(); d++)
+    results.push_back(std::async(std::launch::async, [](time_t t, long offset) { return Lune(t, offset); }, zone_time, offsets[d]));
+
+  zone_moons.clear();
+  for(unsigned int d = 0; d < results.size(); d++)
+    zone_moons.push_back(results[d].get());
+}
+
+
 void nLune::calculateResize() {
   if(!initialized)
     return;
@@ -249,12 +361,152 @@ void nLune::calculateResize() {
 }
 
 
+// ------- Command Line Functions
+
+
+static bool parseDate(const char *str, double& jd) {
+  // Parse an ISO 8601 calendar date into the Julian date of its midnight.
+  // RFC 5545 dates have four digit years, so only 0000 to 9999 are valid.
+  int dd, mm, yyyy;
+  char tail;
+
+  if(std::sscanf(str, "%d-%d-%d%c", &yyyy, &mm, &dd, &tail) != 3)
+    return false;
+
+  if(yyyy < 0 || yyyy > 9999 || mm < 1 || mm > 12 || dd < 1 || dd > 31)
+    return false;
+
+  int jdn;
+  Lune::calculateJulianFromDate(dd, mm, yyyy, jdn);
+
+  // Days past the end of the month roll into the next one, so only dates
+  // which convert back unchanged exist
+  int cd, cm, cy;
+  Lune::calculateGregorian(jdn, cd, cm, cy);
+  if(cd != dd || cm != mm || cy != yyyy)
+    return false;
+
+  jd = jdn - 0.5;
+
+  return true;
+}
+
+
+static int exportCalendar(const int argc, const char *argv[]) {
+  // nlune --ics FROM TO [FILE]
+  double from, to;
+
+  if(argc < 4 || !parseDate(argv[2], from) || !parseDate(argv[3], to)) {
+    std::cerr << "[ERROR]: Usage: nlune --ics YYYY-MM-DD YYYY-MM-DD [FILE]" << std::endl;
+    return 1;
+  }
+
+  LuneCalendar calendar;
+
+  if(argc < 5 || std::string(argv[4]) == "-") {
+    calendar.write(std::cout, from, to);
+    return 0;
+  }
+
+  std::ofstream file(argv[4], std::ios::out | std::ios::binary | std::ios::trunc);
+  if(!file) {
+    std::cerr << "[ERROR]: Unable to open " << argv[4] << " for writing." << std::endl;
+    return 1;
+  }
+
+  calendar.write(file, from, to);
+  return file ? 0 : 1;
+}
+
+
+static bool parseOffset(const std::string& str, long& offset) {
+  // [UTC]+HH[:MM] or [UTC]-HH[:MM]; a bare UTC is zero
+  std::size_t pos = 0;
+
+  if(str.compare(0, 3, "UTC") == 0 || str.compare(0, 3, "GMT") == 0)
+    pos = 3;
+
+  if(pos == str.size()) {
+    offset = 0;
+    return pos > 0;
+  }
+
+  int sign = 1;
+  if(str[pos] == '+' || str[pos] == '-')
+    sign = (str[pos++] == '-') ? -1 : 1;
+
+  int hh = 0, mm = 0;
+  char tail;
+  int fields = std::sscanf(str.c_str() + pos, "%d:%d%c", &hh, &mm, &tail);
+
+  if(fields < 1 || fields > 2 || hh < 0 || hh > 14 || mm < 0 || mm > 59)
+    return false;
+
+  if(fields == 1 && str.find_first_not_of("0123456789", pos) != std::string::npos)
+    return false;
+
+  offset = sign * (hh * 3600L + mm * 60L);
+  return true;
+}
+
+
+static bool parseZones(const std::string& spec, std::vector<nLuneZone>& zones) {
+  // Comma separated list of [LABEL=]OFFSET
+  std::size_t start = 0;
+
+  while(start <= spec.size()) {
+    std::size_t end = spec.find(',', start);
+    if(end == std::string::npos)
+      end = spec.size();
+
+    std::string item = spec.substr(start, end - start);
+    std::size_t eq = item.find('=');
+
+    nLuneZone zone;
+    std::string value = (eq == std::string::npos) ? item : item.substr(eq + 1);
+
+    if(!parseOffset(value, zone.offset))
+      return false;
+
+    if(eq != std::string::npos) {
+      zone.label = item.substr(0, eq);
+    } else {
+      char label[32];
+      int a = int(zone.offset < 0 ? -zone.offset : zone.offset);
+      std::snprintf(label, sizeof(label), "UTC%c%02d:%02d", zone.offset < 0 ? '-' : '+', a / 3600, (a / 60) % 60);
+      zone.label = label;
+    }
+
+    zones.push_back(zone);
+    start = end + 1;
+  }
+
+  return !zones.empty();
+}
+
+
 // ------- Main Function
 
 
 int main(const int argc, const char *argv[]) {
+  // Export the phase calendar without starting ncurses
+  if(argc > 1 && std::string(argv[1]) == "--ics")
+    return exportCalendar(argc, argv);
+
   // Initialize our variables
   nLune moon;
+
+  if(argc > 1 && std::string(argv[1]) == "--zones") {
+    std::vector<nLuneZone> zones;
+
+    if(argc < 3 || !parseZones(argv[2], zones)) {
+      std::cerr << "[ERROR]: Usage: nlune --zones [LABEL=]+HH[:MM][,...]" << std::endl;
+      return 1;
+    }
+
+    moon.setZones(zones);
+  }
+
   moon.initialize();
 
   // Run the application
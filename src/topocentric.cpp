@@ -0,0 +1,233 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+NLUNE - topocentric.cpp
+
+Adapted from "moontool.c" by John Walker, Release 2.5 (See http://www.fourmilab.ch/moontool/)
+and Pyphoon by Igor Chubin, 2016 (See https://github.com/chubin/pyphoon)
+
+Ported to C++ by Christopher M. Short 2018
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions:
+
+The above attribution notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// C Library Includes
+#include <cmath>
+
+// Local Includes
+#include <topocentric.hpp>
+#include <luneconstants.hpp>
+
+
+// ------- Topocentric Constants
+
+static const int samples = 144;                // Samples per day
+static const double refraction = 0.5667;       // Refraction at the horizon, in degrees
+
+
+// ------- Useful mathematical functions
+
+static double fixedangle(double value) { return value - 360.0 * std::floor(value / 360.0); }
+static double todeg(double value) { return value * 180.0 / M_PI; }
+static double torad(double value) { return value * M_PI / 180.0; }
+static double dsin(double value) { return std::sin(torad(value)); }
+static double dcos(double value) { return std::cos(torad(value)); }
+
+static inline double calculateArcSin(double x) {
+  // Abramowitz and Stegun 4.4.46, |error| < 2e-8 radians. Branchless, so
+  // the per observer loops still vectorize; a sine rounded just past one
+  // stays finite through the fabs under the root.
+  double a = std::fabs(x);
+  double p = -0.0012624911;
+  p = p * a + 0.0066700901;
+  p = p * a - 0.0170881256;
+  p = p * a + 0.0308918810;
+  p = p * a - 0.0501743046;
+  p = p * a + 0.0889789874;
+  p = p * a - 0.2145988016;
+  p = p * a + 1.5707963050;
+
+  return std::copysign(M_PI / 2 - std::sqrt(std::fabs(1 - a)) * p, x);
+}
+
+
+// ------- Topocentric Private Implementation
+
+void Topocentric::calculateSample(const double& jd, double& sina, double& cosa, double& sindec, double& cosdec) {
+  eph.calculate(jd);
+
+  double t = (jd - j2000) / 36525.0;
+
+  // Greenwich mean sidereal time and the obliquity of the ecliptic
+  double gmst = fixedangle(280.46061837 + 360.98564736629 * (jd - j2000) + 0.000387933 * t * t);
+  double obliquity = 23.4392911 - 0.0130042 * t;
+
+  // Ecliptic to equatorial coordinates
+  double lambda = eph.getLongitude();
+  double beta = eph.getLatitude();
+
+  double ra = todeg(std::atan2(dsin(lambda) * dcos(obliquity) - std::tan(torad(beta)) * dsin(obliquity), dcos(lambda)));
+  double dec = std::asin(dsin(beta) * dcos(obliquity) + dcos(beta) * dsin(obliquity) * dsin(lambda));
+
+  // Greenwich hour angle; each observer adds its longitude
+  double gha = torad(gmst - ra);
+
+  sina = std::sin(gha);
+  cosa = std::cos(gha);
+  sindec = std::sin(dec);
+  cosdec = std::cos(dec);
+}
+
+
+// ------- Topocentric Public Implementation
+
+void Topocentric::setObservers(const std::vector<double>& lat, const std::vector<double>& lon) {
+  std::size_t count = lat.size() < lon.size() ? lat.size() : lon.size();
+
+  o_sinlat.resize(count);
+  o_coslat.resize(count);
+  o_sinlon.resize(count);
+  o_coslon.resize(count);
+
+  for(std::size_t i = 0; i < count; i++) {
+    o_sinlat[i] = dsin(lat[i]);
+    o_coslat[i] = dcos(lat[i]);
+    o_sinlon[i] = dsin(lon[i]);
+    o_coslon[i] = dcos(lon[i]);
+  }
+
+  w_alt.resize(count);
+  w_ha.resize(count);
+  r_rise.resize(count);
+  r_set.resize(count);
+  r_transit.resize(count);
+}
+
+
+void Topocentric::calculateDay(const double& jd) {
+  const std::size_t count = o_sinlat.size();
+  const double step = 1.0 / samples;
+
+  const double *slat = o_sinlat.data();
+  const double *clat = o_coslat.data();
+  const double *slon = o_sinlon.data();
+  const double *clon = o_coslon.data();
+  double *palt = w_alt.data();
+  double *pha = w_ha.data();
+  double *rise = r_rise.data();
+  double *set = r_set.data();
+  double *transit = r_transit.data();
+
+  // Crossings are found in time order, so the first of each is the least;
+  // days without one are left at infinity until the end
+  for(std::size_t i = 0; i < count; i++) {
+    rise[i] = INFINITY;
+    set[i] = INFINITY;
+    transit[i] = INFINITY;
+  }
+
+  double sina, cosa, sindec, cosdec, sinh0;
+
+  // Prime the previous sample with the start of the day
+  calculateSample(jd, sina, cosa, sindec, cosdec);
+  sinh0 = dsin(0.7275 * eph.getParallax() - refraction);
+
+  #pragma omp simd
+  for(std::size_t i = 0; i < count; i++) {
+    double cha = cosa * clon[i] - sina * slon[i];
+
+    palt[i] = slat[i] * sindec + clat[i] * cosdec * cha - sinh0;
+    pha[i] = sina * clon[i] + cosa * slon[i];
+  }
+
+  for(int s = 1; s <= samples; s++) {
+    double t = jd + s * step;
+
+    // Shared terms for this sample
+    calculateSample(t, sina, cosa, sindec, cosdec);
+
+    // Standard altitude of the Moon's centre at rise and set
+    sinh0 = dsin(0.7275 * eph.getParallax() - refraction);
+
+    // Per observer terms; sin(H) and cos(H) follow from the angle sum
+    // identities so no trigonometry is evaluated per observer, and the
+    // crossings are blends rather than branches.
+    #pragma omp simd
+    for(std::size_t i = 0; i < count; i++) {
+      double cha = cosa * clon[i] - sina * slon[i];
+      double sha = sina * clon[i] + cosa * slon[i];
+      double alt = slat[i] * sindec + clat[i] * cosdec * cha - sinh0;
+      double pa = palt[i];
+      double ph = pha[i];
+
+      // Linear interpolation of the crossing inside this step, pushed to
+      // infinity when there is none
+      double tc = t - step * alt / (alt - pa);
+      double th = t - step * sha / (sha - ph);
+
+      bool up = (pa < 0) & (alt >= 0);
+      bool down = (pa >= 0) & (alt < 0);
+      bool meridian = (ph < 0) & (sha >= 0) & (cha > 0);
+
+      double tr = tc + (up ? 0.0 : INFINITY);
+      double ts = tc + (down ? 0.0 : INFINITY);
+      double tt = th + (meridian ? 0.0 : INFINITY);
+
+      rise[i] = (tr < rise[i]) ? tr : rise[i];
+      set[i] = (ts < set[i]) ? ts : set[i];
+      transit[i] = (tt < transit[i]) ? tt : transit[i];
+
+      palt[i] = alt;
+      pha[i] = sha;
+    }
+  }
+
+  #pragma omp simd
+  for(std::size_t i = 0; i < count; i++) {
+    rise[i] = (rise[i] == INFINITY) ? NAN : rise[i];
+    set[i] = (set[i] == INFINITY) ? NAN : set[i];
+    transit[i] = (transit[i] == INFINITY) ? NAN : transit[i];
+  }
+}
+
+
+void Topocentric::calculateAltitude(const double& jd, std::vector<double>& altitude) {
+  const std::size_t count = o_sinlat.size();
+  altitude.resize(count);
+
+  double sina, cosa, sindec, cosdec;
+  calculateSample(jd, sina, cosa, sindec, cosdec);
+
+  const double parallax = eph.getParallax();
+  const double *slat = o_sinlat.data();
+  const double *clat = o_coslat.data();
+  const double *slon = o_sinlon.data();
+  const double *clon = o_coslon.data();
+  double *palt = altitude.data();
+
+  #pragma omp simd
+  for(std::size_t i = 0; i < count; i++) {
+    double cha = cosa * clon[i] - sina * slon[i];
+    double sinalt = slat[i] * sindec + clat[i] * cosdec * cha;
+
+    // Correct the geocentric altitude for parallax; cos(alt) is never
+    // negative, so it follows from the sine without trigonometry
+    palt[i] = todeg(calculateArcSin(sinalt)) - parallax * std::sqrt(std::fabs(1 - sinalt * sinalt));
+  }
+}